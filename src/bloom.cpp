@@ -0,0 +1,50 @@
+#include "bloom.hpp"
+#include <cmath>
+
+forest::details::bloom_filter::bloom_filter(uint_t count, int bits_per_key)
+{
+	// Some room for keys inserted after the filter was built
+	size = std::max<uint_t>(64, (count + count/4 + 1) * bits_per_key);
+	bits.resize((size + 63) / 64, 0);
+	size = bits.size() * 64;
+	hashes = std::max(1, std::min(16, (int)std::lround(bits_per_key * 0.69)));
+}
+
+forest::details::bloom_filter::~bloom_filter()
+{
+	// dtor
+}
+
+void forest::details::bloom_filter::add(const string& key)
+{
+	// Double hashing: i-th probe is h1 + i*h2
+	std::uint64_t h1 = std::hash<string>()(key);
+	std::uint64_t h2 = (h1 >> 33) | (h1 << 31) | 1;
+	for(int i=0;i<hashes;i++){
+		std::uint64_t b = (h1 + i*h2) % size;
+		bits[b >> 6] |= 1ull << (b & 63);
+	}
+}
+
+bool forest::details::bloom_filter::may_contain(const string& key)
+{
+	std::uint64_t h1 = std::hash<string>()(key);
+	std::uint64_t h2 = (h1 >> 33) | (h1 << 31) | 1;
+	for(int i=0;i<hashes;i++){
+		std::uint64_t b = (h1 + i*h2) % size;
+		if(!(bits[b >> 6] & (1ull << (b & 63)))){
+			return false;
+		}
+	}
+	return true;
+}
+
+int forest::details::bloom_filter::bits_for_rate(double rate)
+{
+	if(rate <= 0 || rate >= 1){
+		return 0;
+	}
+	// m/n = -ln(p) / ln(2)^2
+	int bits = (int)std::ceil(-std::log(rate) / (std::log(2.0) * std::log(2.0)));
+	return std::max(1, std::min(32, bits));
+}
@@ -0,0 +1,32 @@
+#ifndef FOREST_BLOOM_H
+#define FOREST_BLOOM_H
+
+#include <vector>
+#include "dbutils.hpp"
+
+namespace forest{
+namespace details{
+	
+	// Bloom filter over the keys of one leaf
+	class bloom_filter{
+		
+		public:
+			bloom_filter(uint_t count, int bits_per_key);
+			virtual ~bloom_filter();
+			
+			void add(const string& key);
+			bool may_contain(const string& key);
+			
+			// Bits per key giving the false positive rate, 0 if filters are off
+			static int bits_for_rate(double rate);
+			
+		private:
+			std::vector<std::uint64_t> bits;
+			uint_t size;
+			int hashes;
+	};
+	
+} // details
+} // forest
+
+#endif // FOREST_BLOOM_H
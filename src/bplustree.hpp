@@ -24,7 +24,6 @@ namespace details{
 	class BPTLeaf : public BPlusTreeBaseLeafNode<Key, T>{
 		public:
 			using BPlusTreeBaseLeafNode<Key, T>::BPlusTreeBaseLeafNode;
-			~BPTLeaf();
 			
 			typedef BPlusTreeBaseNode<Key, T> Node;
 			typedef std::shared_ptr<Node> node_ptr;
@@ -63,14 +62,6 @@ namespace details{
 		return dynamic_cast<BPTIterator<Key, T>& >(BPlusTreeBaseIterator<Key, T>::operator--());
 	}
 
-	template <class Key, class T>
-	BPTLeaf<Key, T>::~BPTLeaf()
-	{
-		if(data.f){
-			data.f->close();
-		}
-	}
-
 	template <class Key, class T>
 	void BPTLeaf<Key, T>::set_prev_leaf(node_ptr node)
 	{
@@ -119,7 +110,6 @@ namespace details{
 			BPlusTree(int factor, node_ptr node, long count, D* driver);
 			~BPlusTree();
 			void init(node_ptr node);
-			int get_factor();
 			node_ptr get_root_pub();
 			node_ptr get_stem_pub();
 			bool is_stem_pub(node_ptr node);
@@ -192,12 +182,6 @@ namespace details{
 		return this->is_stem(node);
 	}
 
-	template <class Key, class T, typename D>
-	int BPlusTree<Key, T, D>::get_factor()
-	{
-		return this->factor;
-	}
-
 	template <class Key, class T, typename D>
 	void BPlusTree<Key, T, D>::init(node_ptr node)
 	{
@@ -31,6 +31,7 @@ void forest::details::cache::release_cache()
 	leaf_cache.clear();
 	intr_cache.clear();
 	tree_cache.clear();
+	epoch::reclaim();
 }
 
 void forest::details::cache::leaf_unlock()
@@ -72,6 +73,9 @@ void forest::details::cache::check_leaf_ref(string& key)
 		leaf_cache_r.erase(key);
 		get_data(node).bloomed = false;
 		
+		// Threads could still use raw pointer to the node
+		epoch::retire(node);
+		
 		savior->leave(key, SAVE_TYPES::LEAF, node);
 	}
 }
@@ -89,6 +93,7 @@ void forest::details::cache::check_intr_ref(string& key)
 		tree_t::node_ptr node = intr_cache_ref.first;
 		get_data(node).bloomed = false;
 		intr_cache_r.erase(key);
+		epoch::retire(node);
 		savior->leave(key, SAVE_TYPES::INTR, node);
 	}
 }
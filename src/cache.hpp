@@ -7,6 +7,7 @@
 #include "listcache.hpp"
 #include "node_data.hpp"
 #include "savior.hpp"
+#include "epoch.hpp"
 
 namespace forest{
 namespace details{
@@ -0,0 +1,125 @@
+#include "composite_key.hpp"
+
+namespace forest{
+namespace details{
+	
+	// String encoding:
+	// '#'..'}' are kept as is, lower bytes go after '"',
+	// higher bytes go after '~' as two hex digits, '!' ends the string.
+	// Every escape sorts the same way as the byte it replaces.
+	const char KEY_STRING_END = '!';
+	const char KEY_ESCAPE_LOW = '"';
+	const char KEY_ESCAPE_HIGH = '~';
+	const char KEY_HEX[] = "0123456789ABCDEF";
+	
+	int key_hex_value(char c)
+	{
+		if(c >= '0' && c <= '9'){
+			return c - '0';
+		}
+		if(c >= 'A' && c <= 'F'){
+			return c - 'A' + 10;
+		}
+		throw TreeException(TreeException::ERRORS::BAD_INPUT_PARAMETER);
+	}
+	
+} // details
+} // forest
+
+forest::details::key_builder::key_builder()
+{
+	// ctor
+}
+
+forest::details::key_builder::~key_builder()
+{
+	// dtor
+}
+
+forest::details::key_builder& forest::details::key_builder::add_int(std::int64_t value)
+{
+	// Flipping the sign bit puts negative values first
+	buf += encode_uint_key((std::uint64_t)value ^ (1ull << 63));
+	return *this;
+}
+
+forest::details::key_builder& forest::details::key_builder::add_uint(std::uint64_t value)
+{
+	buf += encode_uint_key(value);
+	return *this;
+}
+
+forest::details::key_builder& forest::details::key_builder::add_string(const string& value)
+{
+	for(unsigned char c : value){
+		if(c > KEY_ESCAPE_LOW && c < KEY_ESCAPE_HIGH){
+			buf.push_back(c);
+		} else if(c <= KEY_ESCAPE_LOW){
+			buf.push_back(KEY_ESCAPE_LOW);
+			buf.push_back('#' + c);
+		} else {
+			buf.push_back(KEY_ESCAPE_HIGH);
+			buf.push_back(KEY_HEX[c >> 4]);
+			buf.push_back(KEY_HEX[c & 15]);
+		}
+	}
+	buf.push_back(KEY_STRING_END);
+	return *this;
+}
+
+const forest::details::string& forest::details::key_builder::key()
+{
+	return buf;
+}
+
+forest::details::key_parser::key_parser(const string& key) : key(key)
+{
+	// ctor
+}
+
+forest::details::key_parser::~key_parser()
+{
+	// dtor
+}
+
+std::int64_t forest::details::key_parser::read_int()
+{
+	return (std::int64_t)(read_uint() ^ (1ull << 63));
+}
+
+std::uint64_t forest::details::key_parser::read_uint()
+{
+	if(key.size() - pos < (uint_t)INT_KEY_LENGTH){
+		throw TreeException(TreeException::ERRORS::BAD_INPUT_PARAMETER);
+	}
+	std::uint64_t ret = decode_uint_key(key.substr(pos, INT_KEY_LENGTH));
+	pos += INT_KEY_LENGTH;
+	return ret;
+}
+
+forest::details::string forest::details::key_parser::read_string()
+{
+	string ret;
+	while(pos < key.size()){
+		char c = key[pos++];
+		if(c == KEY_STRING_END){
+			return ret;
+		}
+		if(c == KEY_ESCAPE_LOW && pos < key.size()){
+			ret.push_back(key[pos++] - '#');
+		} else if(c == KEY_ESCAPE_HIGH && pos + 1 < key.size()){
+			ret.push_back((char)(key_hex_value(key[pos]) * 16 + key_hex_value(key[pos+1])));
+			pos += 2;
+		} else if(c > KEY_ESCAPE_LOW && c < KEY_ESCAPE_HIGH){
+			ret.push_back(c);
+		} else {
+			break;
+		}
+	}
+	throw TreeException(TreeException::ERRORS::BAD_INPUT_PARAMETER);
+}
+
+bool forest::details::key_parser::eof()
+{
+	return pos >= key.size();
+}
@@ -0,0 +1,47 @@
+#ifndef FOREST_COMPOSITE_KEY_H
+#define FOREST_COMPOSITE_KEY_H
+
+#include "dbutils.hpp"
+
+namespace forest{
+namespace details{
+	
+	// Builds keys out of tuples of integers and strings.
+	// Keys compare as the tuples do with the plain string order,
+	// and contain printable characters only, so they are safe for node files.
+	class key_builder{
+		
+		public:
+			key_builder();
+			virtual ~key_builder();
+			
+			key_builder& add_int(std::int64_t value);
+			key_builder& add_uint(std::uint64_t value);
+			key_builder& add_string(const string& value);
+			const string& key();
+			
+		private:
+			string buf;
+	};
+	
+	// Reads components of the key made by key_builder in the same order
+	class key_parser{
+		
+		public:
+			key_parser(const string& key);
+			virtual ~key_parser();
+			
+			std::int64_t read_int();
+			std::uint64_t read_uint();
+			string read_string();
+			bool eof();
+			
+		private:
+			string key;
+			uint_t pos = 0;
+	};
+	
+} // details
+} // forest
+
+#endif // FOREST_COMPOSITE_KEY_H
@@ -0,0 +1,72 @@
+#include "cursor.hpp"
+
+forest::details::cursor::cursor(tree_owner_ptr owner) : owner(owner), tree(extract_native_tree(owner)), pos("")
+{
+	// Empty key is the smallest one
+}
+
+forest::details::cursor::cursor(tree_owner_ptr owner, tree_t::key_type from, tree_t::key_type to) : owner(owner), tree(extract_native_tree(owner)), pos(from), to(to), bounded(true)
+{
+	done = !(from < to);
+}
+
+forest::details::cursor::~cursor()
+{
+	// dtor
+}
+
+bool forest::details::cursor::next()
+{
+	keys.clear();
+	vals.clear();
+	
+	if(done){
+		return false;
+	}
+	
+	if(!tree->scan_leaf(pos, inclusive, keys, vals)){
+		done = true;
+	}
+	
+	// Cut the records behind the end of the range
+	if(bounded){
+		auto it = std::lower_bound(keys.begin(), keys.end(), to);
+		if(it != keys.end() || !(pos < to)){
+			done = true;
+		}
+		vals.resize(it - keys.begin());
+		keys.erase(it, keys.end());
+	}
+	
+	return keys.size();
+}
+
+forest::details::uint_t forest::details::cursor::size()
+{
+	return keys.size();
+}
+
+const forest::details::tree_t::key_type& forest::details::cursor::key(uint_t index)
+{
+	check_index(index);
+	return keys[index];
+}
+
+forest::details::detached_leaf_ptr forest::details::cursor::val(uint_t index)
+{
+	check_index(index);
+	return detached_leaf_ptr(new detached_leaf(vals[index]));
+}
+
+forest::details::file_data_t::file_data_reader forest::details::cursor::get_reader(uint_t index)
+{
+	check_index(index);
+	return vals[index]->get_reader();
+}
+
+void forest::details::cursor::check_index(uint_t index)
+{
+	if(index >= keys.size()){
+		throw TreeException(TreeException::ERRORS::BAD_INPUT_PARAMETER);
+	}
+}
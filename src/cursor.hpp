@@ -0,0 +1,45 @@
+#ifndef FOREST_CURSOR_H
+#define FOREST_CURSOR_H
+
+#include "dbutils.hpp"
+#include "tree.hpp"
+#include "tree_owner.hpp"
+#include "detached_leaf.hpp"
+
+namespace forest{
+namespace details{
+	
+	class cursor{
+		
+		public:
+			cursor(tree_owner_ptr owner);
+			cursor(tree_owner_ptr owner, tree_t::key_type from, tree_t::key_type to);
+			virtual ~cursor();
+			
+			bool next();
+			uint_t size();
+			const tree_t::key_type& key(uint_t index);
+			detached_leaf_ptr val(uint_t index);
+			file_data_t::file_data_reader get_reader(uint_t index);
+			
+		private:
+			void check_index(uint_t index);
+			
+			tree_owner_ptr owner;
+			tree_ptr tree;
+			
+			tree_t::key_type pos;
+			tree_t::key_type to;
+			bool inclusive = true;
+			bool bounded = false;
+			bool done = false;
+			
+			// Records of the current leaf, reused between the calls
+			std::vector<tree_t::key_type> keys;
+			std::vector<tree_t::val_type> vals;
+	};
+	
+} // details
+} // forest
+
+#endif // FOREST_CURSOR_H
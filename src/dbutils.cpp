@@ -4,21 +4,13 @@ namespace forest{
 namespace details{
 	
 	std::atomic<int> opened_files_count = 0;
-	std::mutex opened_files_m;
-	std::condition_variable opened_files_cv;
 	
 } // details
 } // forest
 
-forest::details::node_addition& forest::details::get_data(node_ptr node)
+forest::details::node_addition& forest::details::get_data(const node_ptr& node)
 {
-	if(node->is_leaf()){
-		auto r_node = std::static_pointer_cast<BPTLeaf<string, file_data_ptr> >(node);
-		return r_node->data;
-	} else {
-		auto r_node = std::static_pointer_cast<BPTInternal<string, file_data_ptr> >(node);
-		return r_node->data;
-	}
+	return get_data(node.get());
 }
 
 forest::details::node_addition& forest::details::get_data(tree_t::Node* node)
@@ -58,27 +50,44 @@ forest::details::string forest::details::to_string(int num)
 
 forest::details::string forest::details::read_leaf_item(file_data_ptr item)
 {	
-	int sz = item->size();
-	char* buf = new char[sz];
 	auto reader = item->get_reader();
-	reader.read(buf,sz);
-	string ret(buf,sz);
-	delete[] buf;
+	return string(reader.view());
+}
+
+forest::details::string forest::details::encode_uint_key(std::uint64_t value)
+{
+	string ret(INT_KEY_LENGTH, '0');
+	for(int i=INT_KEY_LENGTH-1;i>=0;i--){
+		ret[i] = '0' + (value & 63);
+		value >>= 6;
+	}
 	return ret;
 }
 
-void forest::details::opened_files_inc()
+std::uint64_t forest::details::decode_uint_key(const string& key)
 {
-	std::unique_lock<std::mutex> flock(opened_files_m);
-	while(opened_files_count > OPENED_FILES_LIMIT){
-		opened_files_cv.wait(flock);
+	if(!valid_key(TREE_TYPES::KEY_UINT64, key)){
+		throw TreeException(TreeException::ERRORS::BAD_INPUT_PARAMETER);
 	}
-	opened_files_count++;
+	std::uint64_t ret = 0;
+	for(int i=0;i<INT_KEY_LENGTH;i++){
+		ret = (ret << 6) | (key[i] - '0');
+	}
+	return ret;
 }
 
-void forest::details::opened_files_dec()
+bool forest::details::valid_key(TREE_TYPES type, const string& key)
 {
-	ASSERT(opened_files_count > 0);
-	opened_files_count--;
-	opened_files_cv.notify_all();
+	if(type == TREE_TYPES::KEY_STRING){
+		return true;
+	}
+	if(key.size() != (uint_t)INT_KEY_LENGTH || key[0] > '0' + 15){
+		return false;
+	}
+	for(char c : key){
+		if(c < '0' || c > '0' + 63){
+			return false;
+		}
+	}
+	return true;
 }
@@ -8,14 +8,19 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <algorithm>
 #include <mutex>
 #include <atomic>
 #include <utility>
+#include <map>
 #include <unordered_map>
 #include <unordered_set>
 #include <queue>
 #include <cstdint>
+#include <charconv>
+#include <cctype>
+#include <type_traits>
 //#include <iostream> //for debugging purposes
 
 #include "log.hpp"
@@ -25,12 +30,13 @@
 #include "threading.hpp"
 #include "types.hpp"
 #include "file_data.hpp"
+#include "vfile.hpp"
 
 namespace forest{
 namespace details{
 	
 	// Nodes data methods
-	node_addition& get_data(node_ptr node);
+	node_addition& get_data(const node_ptr& node);
 	node_addition& get_data(tree_t::Node* node);
 	
 	// Leaf methods
@@ -39,9 +45,12 @@ namespace details{
 	string to_string(int num);
 	string read_leaf_item(file_data_ptr item);
 	
-	// Files manager methods
-	void opened_files_inc();
-	void opened_files_dec();
+	// Integer keys are kept as fixed width strings of 6 bit digits,
+	// so string order matches the integer order
+	const int INT_KEY_LENGTH = 11;
+	string encode_uint_key(std::uint64_t value);
+	std::uint64_t decode_uint_key(const string& key);
+	bool valid_key(TREE_TYPES type, const string& key);
 	
 } // details
 } // forest
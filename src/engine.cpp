@@ -0,0 +1,64 @@
+#include "engine.hpp"
+
+namespace forest{
+namespace details{
+	
+	Engine* engine = nullptr;
+	
+} // details
+} // forest
+
+forest::details::Engine::Engine(int count)
+{
+	if(count < 1){
+		count = 1;
+	}
+	for(int i=0;i<count;i++){
+		workers.push_back(std::make_unique<Thread_worker>());
+	}
+}
+
+forest::details::Engine::~Engine()
+{
+	// Thread_worker finishes its queue before it stops
+	workers.clear();
+}
+
+int forest::details::Engine::size()
+{
+	return workers.size();
+}
+
+bool forest::details::Engine::on_worker()
+{
+	return worker_thread;
+}
+
+int forest::details::Engine::get_free_index()
+{
+	// Least loaded worker, the start rotates so idle workers take turns
+	int count = workers.size();
+	int start = next++ % count;
+	int best = start;
+	std::size_t best_load = workers[start]->get_load();
+	for(int i=1;i<count && best_load;i++){
+		int index = (start + i) % count;
+		std::size_t load = workers[index]->get_load();
+		if(load < best_load){
+			best = index;
+			best_load = load;
+		}
+	}
+	return best;
+}
+
+void forest::details::init_engine()
+{
+	engine = new Engine(ENGINE_WORKERS);
+}
+
+void forest::details::release_engine()
+{
+	delete engine;
+	engine = nullptr;
+}
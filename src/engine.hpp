@@ -0,0 +1,77 @@
+#ifndef FOREST_ENGINE_H
+#define FOREST_ENGINE_H
+
+#include <vector>
+#include <future>
+#include <memory>
+#include <functional>
+#include <atomic>
+#include "dbutils.hpp"
+#include "threading.hpp"
+
+namespace forest{
+namespace details{
+	
+	extern int ENGINE_WORKERS;
+	
+	class Engine{
+		public:
+			Engine(int count);
+			virtual ~Engine();
+			
+			template<typename T>
+			std::future<T> submit(int index, std::function<T()> fn);
+			
+			template<typename T>
+			std::future<T> dispatch(std::function<T()> fn);
+			
+			int size();
+			static bool on_worker();
+			
+		private:
+			int get_free_index();
+			
+			std::vector<std::unique_ptr<Thread_worker>> workers;
+			std::atomic<unsigned int> next{0};
+			inline static thread_local bool worker_thread = false;
+	};
+	
+	extern Engine* engine;
+	
+	void init_engine();
+	void release_engine();
+	
+} // details
+} // forest
+
+
+template<typename T>
+std::future<T> forest::details::Engine::submit(int index, std::function<T()> fn)
+{
+	auto task = std::make_shared<std::packaged_task<T()>>(fn);
+	std::future<T> res = task->get_future();
+	
+	// Running right away when called from the worker thread
+	// to prevent workers from waiting for each other
+	if(on_worker()){
+		(*task)();
+		return res;
+	}
+	
+	workers[index % workers.size()]->work([task]{
+		worker_thread = true;
+		(*task)();
+		worker_thread = false;
+	});
+	
+	return res;
+}
+
+template<typename T>
+std::future<T> forest::details::Engine::dispatch(std::function<T()> fn)
+{
+	// Any worker could take the operation
+	return submit<T>(get_free_index(), fn);
+}
+
+#endif // FOREST_ENGINE_H
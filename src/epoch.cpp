@@ -0,0 +1,106 @@
+#include "epoch.hpp"
+
+namespace forest{
+namespace details{
+namespace epoch{
+	
+	struct thread_record{
+		thread_record();
+		~thread_record();
+		std::atomic<uint_t> epoch;
+		int depth = 0;
+	};
+	
+	struct retired_t{
+		uint_t epoch;
+		void_shared ptr;
+	};
+	
+	const size_t RECLAIM_THRESHOLD = 64;
+	
+	std::atomic<uint_t> global_epoch(1);
+	std::mutex records_m, retired_m;
+	std::vector<thread_record*> records;
+	std::vector<retired_t> retired;
+	
+	thread_local thread_record record;
+	
+} // epoch
+} // details
+} // forest
+
+forest::details::epoch::thread_record::thread_record() : epoch(0)
+{
+	std::lock_guard<std::mutex> lock(records_m);
+	records.push_back(this);
+}
+
+forest::details::epoch::thread_record::~thread_record()
+{
+	std::lock_guard<std::mutex> lock(records_m);
+	records.erase(std::find(records.begin(), records.end(), this));
+}
+
+forest::details::epoch::guard::guard()
+{
+	enter();
+}
+
+forest::details::epoch::guard::~guard()
+{
+	leave();
+}
+
+void forest::details::epoch::enter()
+{
+	// Only the outermost guard pins the epoch
+	if(record.depth++ == 0){
+		record.epoch.store(global_epoch.load());
+	}
+}
+
+void forest::details::epoch::leave()
+{
+	ASSERT(record.depth > 0);
+	if(--record.depth == 0){
+		record.epoch.store(0, std::memory_order_release);
+	}
+}
+
+void forest::details::epoch::retire(void_shared ptr)
+{
+	{
+		std::lock_guard<std::mutex> lock(retired_m);
+		retired.push_back({global_epoch.fetch_add(1), std::move(ptr)});
+		if(retired.size() < RECLAIM_THRESHOLD){
+			return;
+		}
+	}
+	reclaim();
+}
+
+void forest::details::epoch::reclaim()
+{
+	// Find the oldest epoch that is still pinned by some thread
+	uint_t min_epoch = global_epoch.load();
+	{
+		std::lock_guard<std::mutex> lock(records_m);
+		for(auto* r : records){
+			uint_t e = r->epoch.load();
+			if(e && e < min_epoch){
+				min_epoch = e;
+			}
+		}
+	}
+	
+	// Items are released outside of the lock as it may trigger destructors
+	std::vector<void_shared> freed;
+	{
+		std::lock_guard<std::mutex> lock(retired_m);
+		auto it = std::partition(retired.begin(), retired.end(), [min_epoch](retired_t& r){ return r.epoch >= min_epoch; });
+		for(auto i = it; i != retired.end(); ++i){
+			freed.push_back(std::move(i->ptr));
+		}
+		retired.erase(it, retired.end());
+	}
+}
@@ -0,0 +1,28 @@
+#ifndef FOREST_EPOCH_H
+#define FOREST_EPOCH_H
+
+#include "dbutils.hpp"
+
+namespace forest{
+namespace details{
+	
+	// Epoch based reclamation
+	namespace epoch{
+		
+		// Keeps everything retired after the guard was created alive
+		// until the guard is destroyed
+		struct guard{
+			guard();
+			~guard();
+		};
+		
+		void enter();
+		void leave();
+		void retire(void_shared ptr);
+		void reclaim();
+	}
+	
+} // details
+} // forest
+
+#endif // FOREST_EPOCH_H
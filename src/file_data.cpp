@@ -1,9 +1,15 @@
 #include "file_data.hpp"
+#include "io.hpp"
+#include "vfile.hpp"
 
 forest::details::file_data_t::file_data_t(file_ptr file, uint_t start, uint_t length) : file(file), start(start), length(length) {
 	// ctor
 }
 
+forest::details::file_data_t::file_data_t(vfile_ptr file, uint_t start, uint_t length) : leaf_file(file), start(start), length(length) {
+	// ctor
+}
+
 forest::details::file_data_t::file_data_t(const char* data, uint_t length) : start(0), length(length) { 
 	data_cached = new char[length]; 
 	std::memcpy(data_cached, data, length); 
@@ -19,10 +25,25 @@ forest::details::uint_t forest::details::file_data_t::size(){
 }
 
 void forest::details::file_data_t::set_file(file_ptr file) { 
+	std::lock_guard<mutex> lock(mtx);
 	this->file = file; 
+	this->leaf_file = nullptr;
+}
+
+void forest::details::file_data_t::set_file(vfile_ptr file) { 
+	std::lock_guard<mutex> lock(mtx);
+	this->leaf_file = file; 
+	this->file = nullptr;
+}
+
+void forest::details::file_data_t::reset_file() { 
+	std::lock_guard<mutex> lock(mtx);
+	this->file = nullptr; 
+	this->leaf_file = nullptr;
 }
 
 void forest::details::file_data_t::set_start(uint_t start) { 
+	std::lock_guard<mutex> lock(mtx);
 	this->start = start; 
 }
 
@@ -44,6 +65,29 @@ void forest::details::file_data_t::set_cache(char* buffer) {
 	cached = true; 
 }
 
+forest::details::file_data_ptr forest::details::file_data_t::snapshot() {
+	std::lock_guard<mutex> lock(mtx);
+	if(cached){
+		return file_data_ptr(new file_data_t(data_cached, length));
+	}
+	if(leaf_file){
+		return file_data_ptr(new file_data_t(leaf_file, start, length));
+	}
+	return file_data_ptr(new file_data_t(file, start, length));
+}
+
+forest::details::file_data_ptr forest::details::file_data_t::snapshot(const block_allocator<file_data_t>& alloc) {
+	// Same as snapshot, but the copy is placed in the arena of the allocator
+	std::lock_guard<mutex> lock(mtx);
+	if(cached){
+		return std::allocate_shared<file_data_t>(alloc, data_cached, length);
+	}
+	if(leaf_file){
+		return std::allocate_shared<file_data_t>(alloc, leaf_file, start, length);
+	}
+	return std::allocate_shared<file_data_t>(alloc, file, start, length);
+}
+
 forest::details::file_data_t::file_data_reader forest::details::file_data_t::get_reader() { 
 	return file_data_reader(this); 
 }
@@ -51,7 +95,12 @@ forest::details::file_data_t::file_data_reader forest::details::file_data_t::get
 
 // File data reader
 forest::details::file_data_t::file_data_reader::file_data_reader(file_data_t* item) : data(item), lock(item->mtx), pos(0) { 
-	if(CACHE_BYTES && data->size() <= (uint_t)CACHE_BYTES && !data->cached) {
+	// Pin the source, so a mapping stays alive while the reader uses it
+	source_leaf = data->leaf_file;
+	source_file = data->file;
+	source_start = data->start;
+	bool mapped = source_leaf && source_leaf->mapped_data();
+	if(CACHE_BYTES && data->size() <= (uint_t)CACHE_BYTES && !data->cached && !mapped) {
 		temp_cached = true;
 		temp_cache = new char[data->size()];
 	}
@@ -59,6 +108,7 @@ forest::details::file_data_t::file_data_reader::file_data_reader(file_data_t* it
 
 forest::details::file_data_t::file_data_reader::~file_data_reader() {
 	if(temp_cached) delete[] temp_cache;
+	if(view_buffer) delete[] view_buffer;
 }
 
 forest::details::uint_t forest::details::file_data_t::file_data_reader::read(char* buffer, uint_t count) { 
@@ -77,9 +127,7 @@ forest::details::uint_t forest::details::file_data_t::file_data_reader::read(cha
 		std::memcpy(buffer, data->data_cached+pos, sz);
 	}
 	else{
-		auto lock = data->file->get_lock();
-		data->file->seekg(data->start + pos);
-		data->file->read(buffer, sz);
+		read_source(buffer, pos, sz);
 		if(temp_cached){
 			std::memcpy(temp_cache + pos, buffer, sz);
 		}
@@ -87,3 +135,83 @@ forest::details::uint_t forest::details::file_data_t::file_data_reader::read(cha
 	pos += sz;
 	return sz;
 }
+
+std::string_view forest::details::file_data_t::file_data_reader::view() {
+	// Bytes stay valid while the reader holds the value's mutex, which the
+	// setters take too, and pins its source. Values neither cached nor mapped
+	// are copied whole into view_buffer, read() streams them instead.
+	if(data->cached){
+		return std::string_view(data->data_cached, data->size());
+	}
+	if(source_leaf && source_leaf->mapped_data()){
+		return std::string_view(source_leaf->mapped_data() + source_start, data->size());
+	}
+	if(view_buffer){
+		return std::string_view(view_buffer, data->size());
+	}
+	if(temp_cached){
+		read_source(temp_cache, 0, data->size());
+		data->data_cached = temp_cache;
+		data->cached = true;
+		temp_cached = false;
+		temp_cache = nullptr;
+		return std::string_view(data->data_cached, data->size());
+	}
+	view_buffer = new char[data->size()];
+	read_source(view_buffer, 0, data->size());
+	return std::string_view(view_buffer, data->size());
+}
+
+void forest::details::file_data_t::file_data_reader::relocate(vfile_ptr file, uint_t start) {
+	// Same as set_file and set_start at once, under the lock the reader holds.
+	// The reader itself keeps reading from its pinned source.
+	data->leaf_file = file;
+	data->file = nullptr;
+	data->start = start;
+}
+
+void forest::details::file_data_t::file_data_reader::read_source(char* buffer, uint_t offset, uint_t count) {
+	if(source_leaf && source_leaf->mapped_data()){
+		std::memcpy(buffer, source_leaf->mapped_data() + source_start + offset, count);
+	}
+	else if(source_leaf){
+		auto h = source_leaf->open();
+		io::read(h.file, buffer, source_start + offset, count, h.fd);
+	}
+	else{
+		auto lock = source_file->get_lock();
+		source_file->stream().flush();
+		io::read(source_file.get(), buffer, source_start + offset, count);
+	}
+}
+
+
+// File data block
+// Room for a descriptor and the control block allocate_shared puts around it
+static const std::size_t BLOCK_SLOT = sizeof(forest::details::file_data_t) + 8*sizeof(void*);
+
+forest::details::file_data_block::file_data_block(uint_t capacity) : arena(new char[capacity*BLOCK_SLOT]), size(capacity*BLOCK_SLOT) {
+	// ctor
+}
+
+forest::details::file_data_block::~file_data_block() {
+	// Descriptors are already destroyed, their control blocks hold the arena
+}
+
+void* forest::details::file_data_block::allocate(std::size_t bytes, std::size_t align) {
+	std::size_t offset = (reinterpret_cast<std::uintptr_t>(arena.get()) + used + align - 1) / align * align - reinterpret_cast<std::uintptr_t>(arena.get());
+	if(offset + bytes > size){
+		// Arena is full, fall back to the heap
+		return ::operator new(bytes);
+	}
+	used = offset + bytes;
+	return arena.get() + offset;
+}
+
+void forest::details::file_data_block::deallocate(void* p) {
+	char* c = static_cast<char*>(p);
+	if(c < arena.get() || c >= arena.get() + size){
+		::operator delete(p);
+	}
+	// Arena slots are released with the whole arena
+}
@@ -6,22 +6,30 @@
 namespace forest{
 namespace details{
 	
+	template<class T> struct block_allocator;
+	
 	class file_data_t{
 		
 		using fn = std::function<void(file_data_t* self, char*, int)>;
 		
 		public:
 			file_data_t(file_ptr file, uint_t start, uint_t length);
+			file_data_t(vfile_ptr file, uint_t start, uint_t length);
 			file_data_t(const char* data, uint_t length);
 			virtual ~file_data_t();
 			uint_t size();
 			void set_file(file_ptr file);
+			void set_file(vfile_ptr file);
+			void reset_file();
 			void set_start(uint_t start);
 			void set_length(uint_t length);
 			void delete_cache();
 			void set_cache(char* buffer);
+			std::shared_ptr<file_data_t> snapshot();
+			std::shared_ptr<file_data_t> snapshot(const block_allocator<file_data_t>& alloc);
 			
 			file_ptr file;
+			vfile_ptr leaf_file;
 			std::mutex m,g,o;
 			bool shared_lock = false;
 			int c = 0;
@@ -31,13 +39,20 @@ namespace details{
 				file_data_reader(file_data_t* item);
 				virtual ~file_data_reader();
 				uint_t read(char* buffer, uint_t count);
+				std::string_view view();
+				void relocate(vfile_ptr file, uint_t start);
 				
 				private:
+					void read_source(char* buffer, uint_t offset, uint_t count);
 					bool temp_cached = false;
 					char* temp_cache;
+					char* view_buffer = nullptr;
 					file_data_t* data;
 					std::lock_guard<mutex> lock;
 					uint_t pos;
+					vfile_ptr source_leaf;
+					file_ptr source_file;
+					uint_t source_start;
 			};
 			file_data_reader get_reader();
 			
@@ -50,6 +65,47 @@ namespace details{
 			bool cached = false;
 	};
 	
+	// Arena for the value descriptors of a whole leaf.
+	// Descriptors are made by allocate_shared with a block_allocator,
+	// so each one is destroyed when its last reference drops, and the
+	// arena lives while any of them is referenced.
+	class file_data_block{
+		
+		public:
+			file_data_block(uint_t capacity);
+			virtual ~file_data_block();
+			void* allocate(std::size_t bytes, std::size_t align);
+			void deallocate(void* p);
+			
+		private:
+			std::unique_ptr<char[]> arena;
+			std::size_t size;
+			std::size_t used = 0;
+	};
+	
+	template<class T>
+	struct block_allocator{
+		using value_type = T;
+		
+		block_allocator(std::shared_ptr<file_data_block> block) : block(std::move(block)) {}
+		template<class U> block_allocator(const block_allocator<U>& other) : block(other.block) {}
+		
+		T* allocate(std::size_t n){
+			return static_cast<T*>(block->allocate(n*sizeof(T), alignof(T)));
+		}
+		void deallocate(T* p, std::size_t n){
+			block->deallocate(p);
+		}
+		template<class U> bool operator==(const block_allocator<U>& other) const {
+			return block == other.block;
+		}
+		template<class U> bool operator!=(const block_allocator<U>& other) const {
+			return block != other.block;
+		}
+		
+		std::shared_ptr<file_data_block> block;
+	};
+	
 } // details
 } // forest
 
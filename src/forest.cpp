@@ -4,6 +4,9 @@ namespace forest{
 namespace details{
 
 	Savior* savior;
+	
+	// Minimal number of keys per worker to split batch search
+	const int PARALLEL_BATCH_SIZE = 1000;
 	bool folding = false;
 
 	tree_ptr FOREST;
@@ -24,11 +27,13 @@ void forest::bloom(details::string path)
 	details::cache::init_cache();
 
 	DBFS::set_root(path);
+	details::io::set_root(path);
 	if(!DBFS::exists(details::ROOT_TREE)){
 		details::create_root_file();
 	} 
 
 	details::init_savior();
+	details::init_engine();
 	details::open_root();
 
 	details::blossomed = true;
@@ -47,6 +52,7 @@ void forest::fold()
 	details::folding = true;
 	details::blossomed = false;
 
+	details::release_engine();
 	details::cache::release_cache();
 	details::release_savior();
 	details::close_root();
@@ -189,7 +195,7 @@ void forest::update_leaf(Tree tree, details::tree_t::key_type key, details::deta
 
 	L_PUB("[forest::update_leaf]-" + t->get_name() + "_" + key);
 
-	details::extract_native_tree(tree)->insert(key, details::extract_leaf_val(val), true);
+	t->insert(key, details::extract_leaf_val(val), true);
 }
 
 void forest::remove_leaf(details::string tree_name, details::tree_t::key_type key)
@@ -216,7 +222,34 @@ void forest::remove_leaf(Tree tree, details::tree_t::key_type key)
 
 	L_PUB("[forest::remove_leaf]-" + t->get_name() + "_" + key);
 
-	details::extract_native_tree(tree)->erase(key);
+	t->erase(key);
+}
+
+forest::size_t forest::remove_range(details::string tree_name, details::tree_t::key_type from, details::tree_t::key_type to)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	details::tree_owner_ptr tree = find_tree(tree_name);
+	details::tree_ptr t = details::extract_native_tree(tree);
+
+	L_PUB("[forest::remove_range]-" + t->get_name() + "_" + from + "_" + to);
+
+	return t->erase_range(from, to);
+}
+
+forest::size_t forest::remove_range(Tree tree, details::tree_t::key_type from, details::tree_t::key_type to)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	details::tree_ptr t = details::extract_native_tree(tree);
+
+	L_PUB("[forest::remove_range]-" + t->get_name() + "_" + from + "_" + to);
+
+	return t->erase_range(from, to);
 }
 
 forest::Leaf forest::find_leaf(details::string tree_name, details::tree_t::key_type key)
@@ -230,9 +263,12 @@ forest::Leaf forest::find_leaf(details::string tree_name, details::tree_t::key_t
 
 	L_PUB("[forest::find_leaf]-KEY_" + nt->get_name() + "_" + key);
 
+	details::tree_t::val_type val;
+	if(nt->hash_find(key, val)){
+		return details::LeafRecord_ptr(new details::LeafRecord(key, val, nt));
+	}
 	details::tree_t::iterator t = nt->find(key);
 	details::LeafRecord_ptr rc = details::LeafRecord_ptr(new details::LeafRecord(t, nt));
-
 	return rc;
 }
 
@@ -247,16 +283,8 @@ forest::Leaf forest::find_leaf(details::string tree_name, LEAF_POSITION position
 
 	L_PUB("[forest::find_leaf]-POS_" + nt->name() + "_" + to_string((int)position));
 
-	details::tree_t::iterator t;
-	if(position == LEAF_POSITION::BEGIN){
-		t = nt->get_tree()->begin();
-	} else if(position == LEAF_POSITION::END) {
-		t = --nt->get_tree()->end();
-	} else {
-		throw TreeException(TreeException::ERRORS::BAD_INPUT_PARAMETER);
-	}
+	details::tree_t::iterator t = nt->find(position);
 	details::LeafRecord_ptr rc = details::LeafRecord_ptr(new details::LeafRecord(t, nt));
-
 	return rc;
 }
 
@@ -271,16 +299,8 @@ forest::Leaf forest::find_leaf(details::string tree_name, details::tree_t::key_t
 
 	L_PUB("[forest::find_leaf]-BNT_" + nt->get_name() + "_" + key + "_" + details::to_string((int)position));
 
-	details::tree_t::iterator t;
-	if(position == LEAF_POSITION::LOWER){
-		t = nt->get_tree()->lower_bound(key);
-	} else if(position == LEAF_POSITION::UPPER) {
-		t = nt->get_tree()->upper_bound(key);
-	} else {
-		throw TreeException(TreeException::ERRORS::BAD_INPUT_PARAMETER);
-	}
+	details::tree_t::iterator t = nt->find(key, position);
 	details::LeafRecord_ptr rc = details::LeafRecord_ptr(new details::LeafRecord(t, nt));
-
 	return rc;
 }
 
@@ -295,9 +315,12 @@ forest::Leaf forest::find_leaf(Tree tree, details::tree_t::key_type key)
 
 	L_PUB("[forest::find_leaf]-KEY_" + nt->get_name() + "_" + key);
 
+	details::tree_t::val_type val;
+	if(nt->hash_find(key, val)){
+		return details::LeafRecord_ptr(new details::LeafRecord(key, val, nt));
+	}
 	details::tree_t::iterator t = nt->find(key);
 	details::LeafRecord_ptr rc = details::LeafRecord_ptr(new details::LeafRecord(t, nt));
-
 	return rc;
 }
 
@@ -311,16 +334,8 @@ forest::Leaf forest::find_leaf(Tree tree, LEAF_POSITION position)
 
 	L_PUB("[forest::find_leaf]-POS_" + nt->get_name() + "_" + details::to_string((int)position));
 
-	details::tree_t::iterator t;
-	if(position == LEAF_POSITION::BEGIN){
-		t = nt->get_tree()->begin();
-	} else if(position == LEAF_POSITION::END) {
-		t = --nt->get_tree()->end();
-	} else {
-		throw TreeException(TreeException::ERRORS::BAD_INPUT_PARAMETER);
-	}
+	details::tree_t::iterator t = nt->find(position);
 	details::LeafRecord_ptr rc = details::LeafRecord_ptr(new details::LeafRecord(t, nt));
-
 	return rc;
 }
 
@@ -334,19 +349,429 @@ forest::Leaf forest::find_leaf(Tree tree, details::tree_t::key_type key, LEAF_PO
 
 	L_PUB("[forest::find_leaf]-BNT_" + nt->get_name() + "_" + key + "_" + details::to_string((int)position));
 
-	details::tree_t::iterator t;
+	details::tree_t::iterator t = nt->find(key, position);
+	details::LeafRecord_ptr rc = details::LeafRecord_ptr(new details::LeafRecord(t, nt));
+	return rc;
+}
+
+std::vector<forest::Leaf> forest::find_leafs(details::string tree_name, std::vector<LeafKey> keys)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	details::tree_owner_ptr tree = find_tree(tree_name);
+	details::tree_ptr nt = details::extract_native_tree(tree);
+
+	L_PUB("[forest::find_leafs]-" + nt->get_name() + "_" + details::to_string(keys.size()));
+
+	return details::find_leafs(nt, keys);
+}
+
+std::vector<forest::Leaf> forest::find_leafs(Tree tree, std::vector<LeafKey> keys)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	details::tree_ptr nt = details::extract_native_tree(tree);
+
+	L_PUB("[forest::find_leafs]-" + nt->get_name() + "_" + details::to_string(keys.size()));
+
+	return details::find_leafs(nt, keys);
+}
+
+void forest::set_bloom_filter(details::string tree_name, double false_positive_rate)
+{
+	L_PUB("[forest::set_bloom_filter]-" + tree_name);
+
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	details::extract_native_tree(find_tree(tree_name))->set_bloom_bits(details::bloom_filter::bits_for_rate(false_positive_rate));
+}
+
+void forest::set_bloom_filter(Tree tree, double false_positive_rate)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	details::extract_native_tree(tree)->set_bloom_bits(details::bloom_filter::bits_for_rate(false_positive_rate));
+}
+
+void forest::set_hash_index(details::string tree_name, bool enabled)
+{
+	L_PUB("[forest::set_hash_index]-" + tree_name);
+
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	details::extract_native_tree(find_tree(tree_name))->set_hash_index(enabled);
+}
+
+void forest::set_hash_index(Tree tree, bool enabled)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	details::extract_native_tree(tree)->set_hash_index(enabled);
+}
+
+forest::Cursor forest::open_cursor(details::string tree_name)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	return details::cursor_ptr(new details::cursor(find_tree(tree_name)));
+}
+
+forest::Cursor forest::open_cursor(details::string tree_name, details::tree_t::key_type from, details::tree_t::key_type to)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	return details::cursor_ptr(new details::cursor(find_tree(tree_name), from, to));
+}
+
+forest::Cursor forest::open_cursor(Tree tree)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	return details::cursor_ptr(new details::cursor(tree));
+}
+
+forest::Cursor forest::open_cursor(Tree tree, details::tree_t::key_type from, details::tree_t::key_type to)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	return details::cursor_ptr(new details::cursor(tree, from, to));
+}
+
+void forest::parallel_scan(details::string tree_name, details::tree_t::key_type from, details::tree_t::key_type to, int threads, ScanCallback callback)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	details::tree_owner_ptr tree = find_tree(tree_name);
+	details::tree_ptr nt = details::extract_native_tree(tree);
+
+	L_PUB("[forest::parallel_scan]-" + nt->get_name() + "_" + from + "_" + to);
+
+	details::parallel_scan(nt, from, to, threads, callback);
+}
+
+void forest::parallel_scan(Tree tree, details::tree_t::key_type from, details::tree_t::key_type to, int threads, ScanCallback callback)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	details::tree_ptr nt = details::extract_native_tree(tree);
+
+	L_PUB("[forest::parallel_scan]-" + nt->get_name() + "_" + from + "_" + to);
+
+	details::parallel_scan(nt, from, to, threads, callback);
+}
+
+forest::Snapshot forest::snapshot(details::string tree_name)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	details::tree_owner_ptr tree = find_tree(tree_name);
+
+	L_PUB("[forest::snapshot]-" + details::extract_native_tree(tree)->get_name());
+
+	return details::snapshot_ptr(new details::snapshot(tree));
+}
+
+forest::Snapshot forest::snapshot(Tree tree)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	L_PUB("[forest::snapshot]-" + details::extract_native_tree(tree)->get_name());
+
+	return details::snapshot_ptr(new details::snapshot(tree));
+}
+
+forest::Leaf forest::find_leaf(Snapshot snap, details::tree_t::key_type key)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	L_PUB("[forest::find_leaf]-SNP_KEY_" + snap->get_tree()->get_name() + "_" + key);
+
+	details::tree_t::val_type val;
+	if(!snap->get(key, val)){
+		throw TreeException(TreeException::ERRORS::LEAF_DOES_NOT_EXISTS);
+	}
+	return details::LeafRecord_ptr(new details::LeafRecord(key, val, snap));
+}
+
+forest::Leaf forest::find_leaf(Snapshot snap, LEAF_POSITION position)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	L_PUB("[forest::find_leaf]-SNP_POS_" + snap->get_tree()->get_name() + "_" + details::to_string((int)position));
+
+	details::tree_t::key_type key;
+	details::tree_t::val_type val;
+	details::snapshot::position pos;
+	if(position == LEAF_POSITION::BEGIN){
+		snap->seek(pos, nullptr, true, true, key, val);
+	} else if(position == LEAF_POSITION::END) {
+		snap->seek(pos, nullptr, true, false, key, val);
+	} else {
+		throw TreeException(TreeException::ERRORS::BAD_INPUT_PARAMETER);
+	}
+	return details::LeafRecord_ptr(new details::LeafRecord(key, val, snap, std::move(pos)));
+}
+
+forest::Leaf forest::find_leaf(Snapshot snap, details::tree_t::key_type key, LEAF_POSITION position)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	L_PUB("[forest::find_leaf]-SNP_BNT_" + snap->get_tree()->get_name() + "_" + key + "_" + details::to_string((int)position));
+
+	details::tree_t::key_type found;
+	details::tree_t::val_type val;
+	details::snapshot::position pos;
 	if(position == LEAF_POSITION::LOWER){
-		t = nt->get_tree()->lower_bound(key);
+		snap->seek(pos, &key, true, true, found, val);
 	} else if(position == LEAF_POSITION::UPPER) {
-		t = nt->get_tree()->upper_bound(key);
+		snap->seek(pos, &key, false, true, found, val);
 	} else {
 		throw TreeException(TreeException::ERRORS::BAD_INPUT_PARAMETER);
 	}
+	return details::LeafRecord_ptr(new details::LeafRecord(found, val, snap, std::move(pos)));
+}
+
+forest::size_t forest::count_range(details::string tree_name, details::tree_t::key_type from, details::tree_t::key_type to)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	details::tree_owner_ptr tree = find_tree(tree_name);
+	details::tree_ptr nt = details::extract_native_tree(tree);
+
+	L_PUB("[forest::count_range]-" + nt->get_name() + "_" + from + "_" + to);
+
+	return nt->count_range(from, to);
+}
+
+forest::size_t forest::count_range(Tree tree, details::tree_t::key_type from, details::tree_t::key_type to)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	details::tree_ptr nt = details::extract_native_tree(tree);
+
+	L_PUB("[forest::count_range]-" + nt->get_name() + "_" + from + "_" + to);
+
+	return nt->count_range(from, to);
+}
+
+forest::Leaf forest::find_leaf_at(details::string tree_name, size_t index)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	details::tree_owner_ptr tree = find_tree(tree_name);
+	details::tree_ptr nt = details::extract_native_tree(tree);
+
+	L_PUB("[forest::find_leaf_at]-" + nt->get_name() + "_" + details::to_string(index));
+
+	details::tree_t::iterator t = nt->find_at(index);
 	details::LeafRecord_ptr rc = details::LeafRecord_ptr(new details::LeafRecord(t, nt));
+	return rc;
+}
 
+forest::Leaf forest::find_leaf_at(Tree tree, size_t index)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	details::tree_ptr nt = details::extract_native_tree(tree);
+
+	L_PUB("[forest::find_leaf_at]-" + nt->get_name() + "_" + details::to_string(index));
+
+	details::tree_t::iterator t = nt->find_at(index);
+	details::LeafRecord_ptr rc = details::LeafRecord_ptr(new details::LeafRecord(t, nt));
 	return rc;
 }
 
+forest::WriteBatch forest::make_batch()
+{
+	return details::write_batch_ptr(new details::write_batch());
+}
+
+void forest::write(WriteBatch batch)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	L_PUB("[forest::write]-" + details::to_string(batch->size()));
+
+	details::apply_batch(batch);
+}
+
+std::future<void> forest::async_insert_leaf(details::string tree_name, details::tree_t::key_type key, details::detached_leaf_ptr val)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	// Tree lookup is done by the worker as well
+	return details::engine->dispatch<void>([=](){
+		insert_leaf(tree_name, key, val);
+	});
+}
+
+std::future<void> forest::async_insert_leaf(Tree tree, details::tree_t::key_type key, details::detached_leaf_ptr val)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	return details::engine->dispatch<void>([=](){
+		insert_leaf(tree, key, val);
+	});
+}
+
+std::future<void> forest::async_update_leaf(details::string tree_name, details::tree_t::key_type key, details::detached_leaf_ptr val)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	return details::engine->dispatch<void>([=](){
+		update_leaf(tree_name, key, val);
+	});
+}
+
+std::future<void> forest::async_update_leaf(Tree tree, details::tree_t::key_type key, details::detached_leaf_ptr val)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	return details::engine->dispatch<void>([=](){
+		update_leaf(tree, key, val);
+	});
+}
+
+std::future<void> forest::async_remove_leaf(details::string tree_name, details::tree_t::key_type key)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	return details::engine->dispatch<void>([=](){
+		remove_leaf(tree_name, key);
+	});
+}
+
+std::future<void> forest::async_remove_leaf(Tree tree, details::tree_t::key_type key)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	return details::engine->dispatch<void>([=](){
+		remove_leaf(tree, key);
+	});
+}
+
+std::future<forest::Leaf> forest::async_find_leaf(details::string tree_name, details::tree_t::key_type key)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	return details::engine->dispatch<Leaf>([=](){
+		return find_leaf(tree_name, key);
+	});
+}
+
+std::future<forest::Leaf> forest::async_find_leaf(details::string tree_name, LEAF_POSITION position)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	return details::engine->dispatch<Leaf>([=](){
+		return find_leaf(tree_name, position);
+	});
+}
+
+std::future<forest::Leaf> forest::async_find_leaf(details::string tree_name, details::tree_t::key_type key, LEAF_POSITION position)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	return details::engine->dispatch<Leaf>([=](){
+		return find_leaf(tree_name, key, position);
+	});
+}
+
+std::future<forest::Leaf> forest::async_find_leaf(Tree tree, details::tree_t::key_type key)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	return details::engine->dispatch<Leaf>([=](){
+		return find_leaf(tree, key);
+	});
+}
+
+std::future<forest::Leaf> forest::async_find_leaf(Tree tree, LEAF_POSITION position)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	return details::engine->dispatch<Leaf>([=](){
+		return find_leaf(tree, position);
+	});
+}
+
+std::future<forest::Leaf> forest::async_find_leaf(Tree tree, details::tree_t::key_type key, LEAF_POSITION position)
+{
+	if(!blooms()){
+		throw TreeException(TreeException::ERRORS::FOREST_FOLDED);
+	}
+
+	return details::engine->dispatch<Leaf>([=](){
+		return find_leaf(tree, key, position);
+	});
+}
+
 forest::DetachedLeaf forest::make_leaf(details::string data)
 {
 	return details::detached_leaf_ptr(new details::detached_leaf(details::leaf_value(data)));
@@ -362,6 +787,27 @@ forest::DetachedLeaf forest::make_leaf(LeafFile file, details::uint_t start, det
 	return details::detached_leaf_ptr(new details::detached_leaf(details::file_data_ptr(new details::file_data_t(file, start, length))));
 }
 
+forest::LeafKey forest::int_key(std::int64_t value)
+{
+	// Flipping the sign bit puts negative values first
+	return details::encode_uint_key((std::uint64_t)value ^ (1ull << 63));
+}
+
+forest::LeafKey forest::uint_key(std::uint64_t value)
+{
+	return details::encode_uint_key(value);
+}
+
+std::int64_t forest::key_to_int(const LeafKey& key)
+{
+	return (std::int64_t)(details::decode_uint_key(key) ^ (1ull << 63));
+}
+
+std::uint64_t forest::key_to_uint(const LeafKey& key)
+{
+	return details::decode_uint_key(key);
+}
+
 forest::LeafFile forest::create_leaf_file()
 {
 	details::file_ptr f(DBFS::create());
@@ -427,6 +873,26 @@ void forest::config_savior_queue_size(int length)
 	details::SAVIOUR_QUEUE_LENGTH = length;
 }
 
+void forest::config_engine_workers(int count)
+{
+	details::ENGINE_WORKERS = count;
+}
+
+void forest::config_mmap_leafs(bool mmap)
+{
+	details::MMAP_LEAFS = mmap;
+}
+
+void forest::config_compress_keys(bool compress)
+{
+	details::COMPRESS_KEYS = compress;
+}
+
+void forest::config_hash_index_size(int count)
+{
+	details::HASH_INDEX_SIZE = count;
+}
+
 /*********************************************************************************/
 
 
@@ -455,6 +921,201 @@ void forest::details::release_savior()
 	delete savior;
 }
 
+std::vector<forest::Leaf> forest::details::find_leafs(tree_ptr tree, std::vector<tree_t::key_type>& keys)
+{
+	uint_t c = keys.size();
+	
+	// Sort keys keeping the input order
+	std::vector<uint_t> order(c);
+	for(uint_t i=0;i<c;i++){
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&keys](uint_t a, uint_t b){
+		return keys[a] < keys[b];
+	});
+	std::vector<tree_t::key_type> sorted(c);
+	for(uint_t i=0;i<c;i++){
+		sorted[i] = keys[order[i]];
+	}
+	
+	std::vector<tree_t::val_type> vals;
+	int parts = std::min((uint_t)engine->size(), c / PARALLEL_BATCH_SIZE);
+	
+	if(parts > 1){
+		// Split sorted keys between workers
+		vals.resize(c);
+		std::vector<std::future<void>> res;
+		for(int p=0;p<parts;p++){
+			uint_t from = c*p/parts;
+			uint_t to = c*(p+1)/parts;
+			res.push_back(engine->submit<void>(p, [&tree, &sorted, &vals, from, to](){
+				std::vector<tree_t::key_type> part_keys(sorted.begin()+from, sorted.begin()+to);
+				std::vector<tree_t::val_type> part_vals;
+				tree->find_batch(part_keys, part_vals);
+				std::move(part_vals.begin(), part_vals.end(), vals.begin()+from);
+			}));
+		}
+		// Wait for all of the parts before rethrowing
+		for(auto& it : res){
+			it.wait();
+		}
+		for(auto& it : res){
+			it.get();
+		}
+	} else {
+		tree->find_batch(sorted, vals);
+	}
+	
+	std::vector<Leaf> ret(c);
+	for(uint_t i=0;i<c;i++){
+		ret[order[i]] = LeafRecord_ptr(new LeafRecord(sorted[i], vals[i], tree));
+	}
+	
+	return ret;
+}
+
+void forest::details::parallel_scan(tree_ptr tree, tree_t::key_type& from, tree_t::key_type& to, int threads, ScanCallback& callback)
+{
+	if(threads < 1){
+		threads = engine->size();
+	}
+	
+	// Partition bounds are separators of the internal nodes
+	std::vector<tree_t::key_type> bounds = tree->split_range(from, to, threads);
+	bounds.insert(bounds.begin(), from);
+	bounds.push_back(to);
+	
+	// Parts run on their own threads, so the engine workers stay free
+	// for the asynchronous operations the callback may call
+	std::vector<std::future<void>> res;
+	std::vector<std::thread> thrds;
+	
+	// Started threads are joined on any exit, even if starting the next one throws
+	struct joiner{
+		std::vector<std::thread>& thrds;
+		~joiner(){
+			for(auto& it : thrds){
+				if(it.joinable()){
+					it.join();
+				}
+			}
+		}
+	} join{thrds};
+	
+	int parts = bounds.size() - 1;
+	res.reserve(parts);
+	thrds.reserve(parts);
+	for(int p=0;p<parts;p++){
+		// Every part reads its own leaf nodes, the next node of the part
+		// is read by an engine worker while the callback goes through the current one
+		std::packaged_task<void()> task([&tree, &bounds, &callback, p](){
+			tree_t::key_type& end = bounds[p+1];
+			tree_t::key_type pos = bounds[p];
+			bool inclusive = true;
+			std::vector<tree_t::key_type> keys, next_keys;
+			std::vector<tree_t::val_type> vals, next_vals;
+			
+			bool more = tree->scan_leaf(pos, inclusive, keys, vals);
+			while(true){
+				bool fetch = more && pos < end;
+				std::future<bool> ahead;
+				if(fetch){
+					ahead = engine->dispatch<bool>([&tree, &pos, &inclusive, &next_keys, &next_vals](){
+						return tree->scan_leaf(pos, inclusive, next_keys, next_vals);
+					});
+				}
+				
+				bool go = true;
+				try{
+					for(uint_t i=0;go && i<keys.size() && keys[i] < end;i++){
+						go = callback(p, LeafRecord_ptr(new LeafRecord(keys[i], vals[i], tree)));
+					}
+				} catch(...){
+					// Prefetch refers to the buffers of the part
+					if(fetch){
+						ahead.wait();
+					}
+					throw;
+				}
+				
+				if(!fetch){
+					break;
+				}
+				more = ahead.get();
+				if(!go){
+					break;
+				}
+				
+				keys.swap(next_keys);
+				vals.swap(next_vals);
+				next_keys.clear();
+				next_vals.clear();
+			}
+		});
+		res.push_back(task.get_future());
+		thrds.push_back(std::thread(std::move(task)));
+	}
+	
+	// Wait for all of the parts before rethrowing
+	for(auto& it : thrds){
+		it.join();
+	}
+	for(auto& it : res){
+		it.get();
+	}
+}
+
+void forest::details::apply_batch(write_batch_ptr batch)
+{
+	// Group mutations by tree, map keeps trees in lock order
+	std::map<string, std::pair<tree_ptr, std::vector<batch_op_t> > > groups;
+	// Owners keep named trees reserved until the batch is written
+	std::vector<tree_owner_ptr> owners;
+	{
+		std::lock_guard<mutex> lock(batch->batch_m);
+		for(auto& entry : batch->entries){
+			tree_owner_ptr owner = entry.tree;
+			if(!owner){
+				// Missing tree fails the whole batch before any change
+				owner = find_tree(entry.tree_name);
+				owners.push_back(owner);
+			}
+			tree_ptr t = extract_native_tree(owner);
+			if(entry.op.type != BATCH_OPS::REMOVE && !valid_key(t->get_type(), entry.op.key)){
+				throw TreeException(TreeException::ERRORS::BAD_INPUT_PARAMETER);
+			}
+			auto& group = groups[t->get_name()];
+			group.first = t;
+			group.second.push_back(entry.op);
+		}
+	}
+	
+	// Hold all trees exclusively, so readers see either none or all of the batch
+	std::vector<tree_ptr> locked;
+	try{
+		for(auto& group : groups){
+			group.second.first->batch_lock();
+			locked.push_back(group.second.first);
+		}
+		// Every tree is checked before any of them is changed
+		for(auto& group : groups){
+			group.second.first->prepare_batch(group.second.second);
+		}
+		for(auto& group : groups){
+			group.second.first->apply_batch(group.second.second);
+		}
+	} catch(...){
+		for(auto& t : locked){
+			t->batch_unlock();
+		}
+		throw;
+	}
+	
+	for(auto& t : locked){
+		t->batch_unlock();
+	}
+}
+
 forest::details::tree_ptr forest::details::reach_tree(string path)
 {
 	cache::tree_lock();
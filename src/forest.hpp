@@ -12,6 +12,11 @@
 #include "savior.hpp"
 #include "detached_leaf.hpp"
 #include "tree_owner.hpp"
+#include "engine.hpp"
+#include "write_batch.hpp"
+#include "snapshot.hpp"
+#include "cursor.hpp"
+#include "composite_key.hpp"
 
 namespace forest{
 
@@ -19,7 +24,13 @@ namespace forest{
 	using Leaf = details::LeafRecord_ptr;
 	using Tree = details::tree_owner_ptr;
 	using DetachedLeaf = details::detached_leaf_ptr;
+	using WriteBatch = details::write_batch_ptr;
+	using Snapshot = details::snapshot_ptr;
+	using Cursor = details::cursor_ptr;
+	using ScanCallback = std::function<bool(int part, Leaf leaf)>;
 	using LeafReader = details::file_data_t::file_data_reader;
+	using KeyBuilder = details::key_builder;
+	using KeyParser = details::key_parser;
 	using LeafFile = details::file_ptr;
 	using LeafKey = details::tree_t::key_type;
 	using size_t = details::uint_t;
@@ -34,6 +45,7 @@ namespace forest{
 	void insert_leaf(details::string tree_name, details::tree_t::key_type key, details::detached_leaf_ptr val);
 	void update_leaf(details::string tree_name, details::tree_t::key_type key, details::detached_leaf_ptr val);
 	void remove_leaf(details::string tree_name, details::tree_t::key_type key);
+	size_t remove_range(details::string tree_name, details::tree_t::key_type from, details::tree_t::key_type to);
 	Leaf find_leaf(details::string tree_name, details::tree_t::key_type key);
 	Leaf find_leaf(details::string tree_name, LEAF_POSITION position = LEAF_POSITION::BEGIN);
 	Leaf find_leaf(details::string tree_name, details::tree_t::key_type key, LEAF_POSITION position);
@@ -42,16 +54,76 @@ namespace forest{
 	void insert_leaf(Tree tree, details::tree_t::key_type key, details::detached_leaf_ptr val);
 	void update_leaf(Tree tree, details::tree_t::key_type key, details::detached_leaf_ptr val);
 	void remove_leaf(Tree tree, details::tree_t::key_type key);
+	size_t remove_range(Tree tree, details::tree_t::key_type from, details::tree_t::key_type to);
 	Leaf find_leaf(Tree tree, details::tree_t::key_type key);
 	Leaf find_leaf(Tree tree, LEAF_POSITION position = LEAF_POSITION::BEGIN);
 	Leaf find_leaf(Tree tree, details::tree_t::key_type key, LEAF_POSITION position);
 
+	// Batch search
+	std::vector<Leaf> find_leafs(details::string tree_name, std::vector<LeafKey> keys);
+	std::vector<Leaf> find_leafs(Tree tree, std::vector<LeafKey> keys);
+
+	// Tree options
+	void set_bloom_filter(details::string tree_name, double false_positive_rate);
+	void set_bloom_filter(Tree tree, double false_positive_rate);
+	void set_hash_index(details::string tree_name, bool enabled);
+	void set_hash_index(Tree tree, bool enabled);
+
+	// Cursors
+	Cursor open_cursor(details::string tree_name);
+	Cursor open_cursor(details::string tree_name, details::tree_t::key_type from, details::tree_t::key_type to);
+	Cursor open_cursor(Tree tree);
+	Cursor open_cursor(Tree tree, details::tree_t::key_type from, details::tree_t::key_type to);
+
+	// Parallel scan
+	void parallel_scan(details::string tree_name, details::tree_t::key_type from, details::tree_t::key_type to, int threads, ScanCallback callback);
+	void parallel_scan(Tree tree, details::tree_t::key_type from, details::tree_t::key_type to, int threads, ScanCallback callback);
+
+	// Snapshots
+	Snapshot snapshot(details::string tree_name);
+	Snapshot snapshot(Tree tree);
+	Leaf find_leaf(Snapshot snap, details::tree_t::key_type key);
+	Leaf find_leaf(Snapshot snap, LEAF_POSITION position = LEAF_POSITION::BEGIN);
+	Leaf find_leaf(Snapshot snap, details::tree_t::key_type key, LEAF_POSITION position);
+
+	// Order statistics
+	size_t count_range(details::string tree_name, details::tree_t::key_type from, details::tree_t::key_type to);
+	size_t count_range(Tree tree, details::tree_t::key_type from, details::tree_t::key_type to);
+	Leaf find_leaf_at(details::string tree_name, size_t index);
+	Leaf find_leaf_at(Tree tree, size_t index);
+
+	// Write batch
+	WriteBatch make_batch();
+	void write(WriteBatch batch);
+
+	// Asynchronous tree operations by name
+	std::future<void> async_insert_leaf(details::string tree_name, details::tree_t::key_type key, details::detached_leaf_ptr val);
+	std::future<void> async_update_leaf(details::string tree_name, details::tree_t::key_type key, details::detached_leaf_ptr val);
+	std::future<void> async_remove_leaf(details::string tree_name, details::tree_t::key_type key);
+	std::future<Leaf> async_find_leaf(details::string tree_name, details::tree_t::key_type key);
+	std::future<Leaf> async_find_leaf(details::string tree_name, LEAF_POSITION position = LEAF_POSITION::BEGIN);
+	std::future<Leaf> async_find_leaf(details::string tree_name, details::tree_t::key_type key, LEAF_POSITION position);
+
+	// Asynchronous tree operations by tree
+	std::future<void> async_insert_leaf(Tree tree, details::tree_t::key_type key, details::detached_leaf_ptr val);
+	std::future<void> async_update_leaf(Tree tree, details::tree_t::key_type key, details::detached_leaf_ptr val);
+	std::future<void> async_remove_leaf(Tree tree, details::tree_t::key_type key);
+	std::future<Leaf> async_find_leaf(Tree tree, details::tree_t::key_type key);
+	std::future<Leaf> async_find_leaf(Tree tree, LEAF_POSITION position = LEAF_POSITION::BEGIN);
+	std::future<Leaf> async_find_leaf(Tree tree, details::tree_t::key_type key, LEAF_POSITION position);
+
 	// Leaf Builder
 	DetachedLeaf make_leaf(details::string data);
 	DetachedLeaf make_leaf(char* buffer, details::uint_t length);
 	DetachedLeaf make_leaf(LeafFile file, details::uint_t start, details::uint_t length);
 	LeafFile create_leaf_file();
 
+	// Integer keys
+	LeafKey int_key(std::int64_t value);
+	LeafKey uint_key(std::uint64_t value);
+	std::int64_t key_to_int(const LeafKey& key);
+	std::uint64_t key_to_uint(const LeafKey& key);
+
 	// Init methods
 	void bloom(details::string path);
 	void fold();
@@ -73,6 +145,10 @@ namespace forest{
 	void config_opened_files_limit(int count);
 	void config_save_schedule_mks(int mks);
 	void config_savior_queue_size(int length);
+	void config_engine_workers(int count);
+	void config_mmap_leafs(bool mmap);
+	void config_compress_keys(bool compress);
+	void config_hash_index_size(int count);
 
 	//////////// Private ////////////
 
@@ -89,6 +165,8 @@ namespace forest{
 		tree_ptr get_tree(string path);
 		tree_ptr reach_tree(string path);
 		void leave_tree(string path);
+		std::vector<Leaf> find_leafs(tree_ptr tree, std::vector<tree_t::key_type>& keys);
+		void parallel_scan(tree_ptr tree, tree_t::key_type& from, tree_t::key_type& to, int threads, ScanCallback& callback);
 
 		// Other methods
 		void init_savior();
@@ -0,0 +1,337 @@
+#include "io.hpp"
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef FOREST_IO_URING
+#include <liburing.h>
+#endif
+
+namespace forest{
+namespace details{
+namespace io{
+	
+	const uint_t HEAD_CHUNK = 4096;
+	
+	string ROOT;
+	
+#ifdef FOREST_IO_URING
+	const unsigned RING_DEPTH = 64;
+	
+	// Ring per thread, so no locks are needed to submit requests
+	struct ring_t{
+		ring_t(){ ready = io_uring_queue_init(RING_DEPTH, &ring, 0) == 0; }
+		~ring_t(){ if(ready) io_uring_queue_exit(&ring); }
+		
+		struct io_uring ring;
+		bool ready;
+		
+		// Requests of all batches of the thread that are not reaped yet
+		unsigned flight = 0;
+	};
+	
+	ring_t& get_ring(){
+		thread_local ring_t ring;
+		return ring;
+	}
+#endif
+	
+	void fail(bool write){
+		if(write){
+			L_ERR("[io::batch]-(cannot write file)");
+			throw TreeException(TreeException::ERRORS::CANNOT_WRITE_FILE);
+		}
+		L_ERR("[io::batch]-(cannot read file)");
+		throw TreeException(TreeException::ERRORS::CANNOT_READ_FILE);
+	}
+	
+	// Finishes short and not started requests in sync mode
+	bool transfer(DBFS::File* file, int fd, char* buffer, uint_t offset, uint_t length, bool write, uint_t done){
+		if(fd >= 0){
+			while(done < length){
+				ssize_t res;
+				if(write){
+					res = ::pwrite(fd, buffer + done, length - done, offset + done);
+				} else {
+					res = ::pread(fd, buffer + done, length - done, offset + done);
+				}
+				if(res <= 0){
+					break;
+				}
+				done += res;
+			}
+		} else if(done < length){
+			std::fstream& s = file->stream();
+			if(write){
+				s.seekp(offset + done);
+				s.write(buffer + done, length - done);
+				done = s.fail() ? done : length;
+			} else {
+				s.seekg(offset + done);
+				s.read(buffer + done, length - done);
+				done += s.gcount();
+				s.clear();
+			}
+		}
+		
+		return done >= length;
+	}
+	
+} // io
+} // details
+} // forest
+
+
+forest::details::io::batch::~batch()
+{
+	// Kernel could still use the buffers
+	try{
+		wait();
+	} catch(...){
+		// Errors are logged already
+	}
+}
+
+void forest::details::io::batch::read(DBFS::File* file, char* buffer, uint_t offset, uint_t length, int fd)
+{
+	reqs.push_back({this, file, fd, buffer, offset, length, false});
+}
+
+void forest::details::io::batch::write(DBFS::File* file, const char* buffer, uint_t offset, uint_t length, int fd)
+{
+	reqs.push_back({this, file, fd, const_cast<char*>(buffer), offset, length, true});
+}
+
+forest::details::uint_t forest::details::io::batch::size()
+{
+	return reqs.size() + pending;
+}
+
+void forest::details::io::batch::submit()
+{
+	if(reqs.empty()){
+		return;
+	}
+	
+#ifdef FOREST_IO_URING
+	if(get_ring().ready){
+		submit_ring();
+		return;
+	}
+#endif
+	
+	// Without the ring requests are done right away
+	std::vector<request> list;
+	list.swap(reqs);
+	for(auto& req : list){
+		if(!complete(req, 0)){
+			fail(req.write);
+		}
+	}
+}
+
+void forest::details::io::batch::wait()
+{
+#ifdef FOREST_IO_URING
+	while(pending){
+		reap_ring();
+	}
+#endif
+	flight.clear();
+	
+	if(failed){
+		bool write = failed_write;
+		failed = failed_write = false;
+		fail(write);
+	}
+}
+
+void forest::details::io::batch::submit_ring()
+{
+#ifdef FOREST_IO_URING
+	ring_t& r = get_ring();
+	std::vector<request> list;
+	list.swap(reqs);
+	
+	for(auto& it : list){
+		if(it.fd < 0){
+			// Stream is not shared with the ring
+			if(!complete(it, 0)){
+				fail(it.write);
+			}
+			continue;
+		}
+		
+		// Room is made by reaping earlier requests of the thread
+		while(r.flight >= RING_DEPTH){
+			reap_ring();
+		}
+		struct io_uring_sqe* sqe = io_uring_get_sqe(&r.ring);
+		if(!sqe){
+			reap_ring();
+			sqe = io_uring_get_sqe(&r.ring);
+		}
+		if(!sqe){
+			L_ERR("[io::batch::submit_ring]-(cannot queue requests)");
+			fail(it.write);
+		}
+		
+		// Requests keep their place until they are reaped
+		flight.push_back(it);
+		request& req = flight.back();
+		if(req.write){
+			io_uring_prep_write(sqe, req.fd, req.buffer, req.length, req.offset);
+		} else {
+			io_uring_prep_read(sqe, req.fd, req.buffer, req.length, req.offset);
+		}
+		io_uring_sqe_set_data(sqe, &req);
+		r.flight++;
+		pending++;
+	}
+	
+	while(io_uring_sq_ready(&r.ring) > 0){
+		if(io_uring_submit(&r.ring) <= 0){
+			L_ERR("[io::batch::submit_ring]-(cannot submit requests)");
+			throw TreeException(TreeException::ERRORS::CANNOT_READ_FILE);
+		}
+	}
+#endif
+}
+
+void forest::details::io::batch::reap_ring()
+{
+#ifdef FOREST_IO_URING
+	ring_t& r = get_ring();
+	
+	// Prepared requests must be in flight before waiting for them
+	if(io_uring_sq_ready(&r.ring) > 0){
+		io_uring_submit(&r.ring);
+	}
+	
+	struct io_uring_cqe* cqe;
+	if(io_uring_wait_cqe(&r.ring, &cqe) < 0){
+		L_ERR("[io::batch::reap_ring]-(cannot complete requests)");
+		throw TreeException(TreeException::ERRORS::CANNOT_READ_FILE);
+	}
+	request* req = (request*)io_uring_cqe_get_data(cqe);
+	int res = cqe->res;
+	io_uring_cqe_seen(&r.ring, cqe);
+	r.flight--;
+	
+	// Request could belong to another batch of the thread
+	if(!complete(*req, res < 0 ? 0 : res)){
+		req->owner->failed = true;
+		req->owner->failed_write = req->owner->failed_write || req->write;
+	}
+	req->owner->pending--;
+#endif
+}
+
+bool forest::details::io::batch::complete(request& req, uint_t done)
+{
+	return transfer(req.file, req.fd, req.buffer, req.offset, req.length, req.write, done);
+}
+
+void forest::details::io::set_root(string path)
+{
+	ROOT = path;
+}
+
+int forest::details::io::open(const string& name)
+{
+	return ROOT.size() ? ::open((ROOT + "/" + name).c_str(), O_RDWR) : -1;
+}
+
+void forest::details::io::close(int fd)
+{
+	if(fd >= 0){
+		::close(fd);
+	}
+}
+
+void forest::details::io::read(DBFS::File* file, char* buffer, uint_t offset, uint_t length, int fd)
+{
+	// Single requests are not worth the ring
+	if(!transfer(file, fd, buffer, offset, length, false, 0)){
+		fail(false);
+	}
+}
+
+void forest::details::io::write(DBFS::File* file, const char* buffer, uint_t offset, uint_t length, int fd)
+{
+	if(!transfer(file, fd, const_cast<char*>(buffer), offset, length, true, 0)){
+		fail(true);
+	}
+}
+
+forest::details::string forest::details::io::read_head(DBFS::File* file, int lines)
+{
+	string ret;
+	uint_t pos = 0;
+	std::fstream& s = file->stream();
+	
+	while(lines > 0){
+		ret.resize(pos + HEAD_CHUNK);
+		s.seekg(pos);
+		s.read(&ret[pos], HEAD_CHUNK);
+		uint_t got = s.gcount();
+		s.clear();
+		
+		// Cut the string after the last requested line
+		for(uint_t i=pos;i<pos+got;i++){
+			if(ret[i] == '\n' && --lines == 0){
+				got = i - pos + 1;
+				break;
+			}
+		}
+		pos += got;
+		
+		if(got < HEAD_CHUNK && lines > 0){
+			// EOF reached
+			break;
+		}
+	}
+	
+	ret.resize(pos);
+	return ret;
+}
+
+const char* forest::details::io::map(DBFS::File* file, uint_t& size)
+{
+	// Mapping stays valid after the descriptor is closed
+	int fd = open(file->name());
+	struct stat st;
+	
+	if(fd < 0 || ::fstat(fd, &st) < 0 || st.st_size <= 0){
+		close(fd);
+		return nullptr;
+	}
+	
+	void* data = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(data == MAP_FAILED){
+		L_ERR("[io::map]-(cannot map file)");
+		return nullptr;
+	}
+	
+	size = st.st_size;
+	return static_cast<const char*>(data);
+}
+
+void forest::details::io::unmap(const char* data, uint_t size)
+{
+	if(data){
+		::munmap(const_cast<char*>(data), size);
+	}
+}
+
+forest::details::uint_t forest::details::io::head_length(const char* data, uint_t size, int lines)
+{
+	for(uint_t i=0;i<size;i++){
+		if(data[i] == '\n' && --lines == 0){
+			return i + 1;
+		}
+	}
+	return size;
+}
@@ -0,0 +1,79 @@
+#ifndef FOREST_IO_H
+#define FOREST_IO_H
+
+#include <vector>
+#include <list>
+#include "dbutils.hpp"
+
+namespace forest{
+namespace details{
+namespace io{
+	
+	// Bytes of values buffered before submitting writes
+	const uint_t BATCH_BYTES = 1 << 20;
+	
+	// Requests are executed by io_uring when built with FOREST_IO_URING,
+	// by pread/pwrite on the descriptor passed with the request,
+	// and by the file stream when there is none.
+	// With io_uring submit() returns while requests are in flight,
+	// wait() completes them, so buffers must be kept until then.
+	// File locks are not taken here, it's up to the caller.
+	class batch{
+		
+		struct request{
+			batch* owner;
+			DBFS::File* file;
+			int fd;
+			char* buffer;
+			uint_t offset;
+			uint_t length;
+			bool write;
+		};
+		
+		public:
+			~batch();
+			void read(DBFS::File* file, char* buffer, uint_t offset, uint_t length, int fd=-1);
+			void write(DBFS::File* file, const char* buffer, uint_t offset, uint_t length, int fd=-1);
+			void submit();
+			void wait();
+			uint_t size();
+			
+		private:
+			void submit_ring();
+			static void reap_ring();
+			static bool complete(request& req, uint_t done);
+			
+			std::vector<request> reqs;
+			std::list<request> flight;
+			uint_t pending = 0;
+			bool failed = false;
+			bool failed_write = false;
+	};
+	
+	// Same root the DBFS files are placed in
+	void set_root(string path);
+	
+	// Own descriptor of the file opened by its name under the root,
+	// negative if the file could not be opened
+	int open(const string& name);
+	void close(int fd);
+	
+	// Single requests
+	void read(DBFS::File* file, char* buffer, uint_t offset, uint_t length, int fd=-1);
+	void write(DBFS::File* file, const char* buffer, uint_t offset, uint_t length, int fd=-1);
+	
+	// Reads file from the beginning till `lines` new line characters found or eof
+	string read_head(DBFS::File* file, int lines);
+	
+	// Read-only mapping of the whole file, nullptr if it's not possible
+	const char* map(DBFS::File* file, uint_t& size);
+	void unmap(const char* data, uint_t size);
+	
+	// Same as read_head, but over the mapped bytes
+	uint_t head_length(const char* data, uint_t size, int lines);
+	
+} // io
+} // details
+} // forest
+
+#endif // FOREST_IO_H
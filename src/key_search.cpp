@@ -0,0 +1,139 @@
+#include "key_search.hpp"
+#include "node_data.hpp"
+
+#if defined(__AVX2__) || defined(__SSE4_2__)
+#include <immintrin.h>
+#endif
+
+namespace forest{
+namespace details{
+	
+	// Number of set bits of the 4 bit mask
+	const int MASK_BITS[16] = {0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4};
+	
+	// Prefixes left to the vector compares after the binary search
+	const uint_t RANK_BLOCK = 16;
+	
+	key_index_ptr make_key_index(tree_t::Node* node, bool exact)
+	{
+		auto* keys = node->get_keys();
+		auto idx = std::make_shared<key_index_t>();
+		idx->keys = keys;
+		idx->exact = exact;
+		idx->prefixes.reserve(keys->size());
+		for(auto& key : *keys){
+			idx->prefixes.push_back(exact ? decode_uint_key(key) : key_prefix(key));
+		}
+		return idx;
+	}
+	
+} // details
+} // forest
+
+std::uint64_t forest::details::key_prefix(const string& key)
+{
+	std::uint64_t ret = 0;
+	uint_t sz = std::min<uint_t>(key.size(), 8);
+	for(uint_t i=0;i<sz;i++){
+		ret |= (std::uint64_t)(unsigned char)key[i] << (56 - 8*i);
+	}
+	return ret;
+}
+
+forest::details::uint_t forest::details::prefix_rank(const std::uint64_t* arr, uint_t n, std::uint64_t value, bool inclusive)
+{
+	// Binary search narrows the range down to a block,
+	// the block is counted by vector compares
+	uint_t lo = 0, hi = n;
+	while(hi - lo > RANK_BLOCK){
+		uint_t mid = lo + (hi - lo) / 2;
+		if(inclusive ? arr[mid] <= value : arr[mid] < value){
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	
+	// Prefixes are sorted, so the rank is lo plus the matching lanes of the block.
+	// Signed compares work as unsigned ones with flipped sign bits.
+	uint_t i = lo;
+	uint_t c = 0;
+#if defined(__AVX2__)
+	const __m256i sign4 = _mm256_set1_epi64x(INT64_MIN);
+	const __m256i v4 = _mm256_xor_si256(_mm256_set1_epi64x(value), sign4);
+	for(;i+4<=hi;i+=4){
+		__m256i a = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(arr+i)), sign4);
+		__m256i m = inclusive ? _mm256_cmpgt_epi64(a, v4) : _mm256_cmpgt_epi64(v4, a);
+		int bits = MASK_BITS[_mm256_movemask_pd(_mm256_castsi256_pd(m))];
+		c += inclusive ? 4 - bits : bits;
+	}
+#endif
+#if defined(__SSE4_2__)
+	const __m128i sign2 = _mm_set1_epi64x(INT64_MIN);
+	const __m128i v2 = _mm_xor_si128(_mm_set1_epi64x(value), sign2);
+	for(;i+2<=hi;i+=2){
+		__m128i a = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(arr+i)), sign2);
+		__m128i m = inclusive ? _mm_cmpgt_epi64(a, v2) : _mm_cmpgt_epi64(v2, a);
+		int bits = MASK_BITS[_mm_movemask_pd(_mm_castsi128_pd(m))];
+		c += inclusive ? 2 - bits : bits;
+	}
+#endif
+	
+	// Scalar fallback and the tail
+	for(;i<hi;i++){
+		c += inclusive ? arr[i] <= value : arr[i] < value;
+	}
+	return lo + c;
+}
+
+forest::details::uint_t forest::details::node_upper_bound(tree_t::Node* node, const tree_t::key_type& key, bool exact)
+{
+	auto kb = node->keys_iterator();
+	auto ke = node->keys_iterator_end();
+	
+	// Keys out of the integer format are compared as usual
+	if(!has_data(node) || (exact && !valid_key(TREE_TYPES::KEY_UINT64, key))){
+		return std::upper_bound(kb, ke, key) - kb;
+	}
+	
+	node_data_t* data = node_data(node);
+	key_index_ptr idx = std::atomic_load(&data->key_index);
+	if(!idx || idx->keys != node->get_keys() || idx->exact != exact || idx->prefixes.size() != (uint_t)(ke - kb)){
+		idx = make_key_index(node, exact);
+		std::atomic_store(&data->key_index, idx);
+	}
+	
+	const std::uint64_t* arr = idx->prefixes.data();
+	uint_t n = idx->prefixes.size();
+	std::uint64_t p = exact ? decode_uint_key(key) : key_prefix(key);
+	uint_t hi = prefix_rank(arr, n, p, true);
+	if(exact){
+		return hi;
+	}
+	
+	// Full keys are compared only for the equal prefixes
+	uint_t lo = prefix_rank(arr, hi, p, false);
+	if(lo == hi){
+		return hi;
+	}
+	return std::upper_bound(kb + lo, kb + hi, key) - kb;
+}
+
+void forest::details::build_key_index(tree_t::Node* node, bool exact)
+{
+	std::atomic_store(&node_data(node)->key_index, make_key_index(node, exact));
+}
+
+void forest::details::share_key_index(tree_t::Node* node, tree_t::Node* original)
+{
+	if(has_data(node) && has_data(original)){
+		std::atomic_store(&node_data(node)->key_index, std::atomic_load(&node_data(original)->key_index));
+	}
+}
+
+void forest::details::reset_key_index(tree_t::Node* node)
+{
+	if(has_data(node)){
+		std::atomic_store(&node_data(node)->key_index, key_index_ptr());
+	}
+}
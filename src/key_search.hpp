@@ -0,0 +1,39 @@
+#ifndef FOREST_KEY_SEARCH_H
+#define FOREST_KEY_SEARCH_H
+
+#include <vector>
+#include "dbutils.hpp"
+
+namespace forest{
+namespace details{
+	
+	// Packed prefixes of the internal node keys.
+	// Exact prefixes are whole integer keys, others are the first 8 bytes.
+	struct key_index_t {
+		const tree_t::Node::keys_type* keys;
+		bool exact;
+		std::vector<std::uint64_t> prefixes;
+	};
+	
+	using key_index_ptr = std::shared_ptr<const key_index_t>;
+	
+	// First 8 bytes of the key as big-endian number, so numbers order as keys do
+	std::uint64_t key_prefix(const string& key);
+	
+	// Number of sorted prefixes less than the value, or not greater if inclusive.
+	// Binary search down to a small block, that is counted with AVX2 or SSE4.2
+	// compares when built with them.
+	uint_t prefix_rank(const std::uint64_t* arr, uint_t n, std::uint64_t value, bool inclusive);
+	
+	// std::upper_bound over the keys of the internal node through its packed prefixes
+	uint_t node_upper_bound(tree_t::Node* node, const tree_t::key_type& key, bool exact);
+	
+	// Prefixes are built once per read node and shared with its proxies
+	void build_key_index(tree_t::Node* node, bool exact);
+	void share_key_index(tree_t::Node* node, tree_t::Node* original);
+	void reset_key_index(tree_t::Node* node);
+	
+} // details
+} // forest
+
+#endif // FOREST_KEY_SEARCH_H
@@ -19,19 +19,65 @@ forest::details::LeafRecord::LeafRecord(tree_t::iterator it, tree_ptr tree) : it
 	// main ctor
 }
 
+forest::details::LeafRecord::LeafRecord(tree_t::key_type key, tree_t::val_type val, tree_ptr tree) : tree(tree), detached(true), d_key(key), d_val(val)
+{
+	tree->tree_reserve();
+}
+
+forest::details::LeafRecord::LeafRecord(tree_t::key_type key, tree_t::val_type val, snapshot_ptr snap, snapshot::position s_pos) : tree(snap->get_tree()), detached(true), d_key(key), d_val(val), snap(snap), s_pos(std::move(s_pos))
+{
+	tree->tree_reserve();
+}
+
 bool forest::details::LeafRecord::eof()
 {
+	if(detached){
+		return !d_val;
+	}
 	return it.expired();
 }
 
 bool forest::details::LeafRecord::move_forward()
 {
+	if(snap){
+		if(eof()){
+			return false;
+		}
+		if(!snap->move(s_pos, true, d_key, d_val)){
+			d_val = nullptr;
+		}
+		return !eof();
+	}
+	if(detached){
+		if(eof()){
+			return false;
+		}
+		// Already points to the next record if the key was removed
+		if(!attach()){
+			return !eof();
+		}
+	}
 	++it;
 	return !eof();
 }
 
 bool forest::details::LeafRecord::move_back()
 {
+	if(snap){
+		if(eof()){
+			return false;
+		}
+		if(!snap->move(s_pos, false, d_key, d_val)){
+			d_val = nullptr;
+		}
+		return !eof();
+	}
+	if(detached){
+		if(eof()){
+			return false;
+		}
+		attach();
+	}
 	--it;
 	return !eof();
 }
@@ -41,6 +87,9 @@ forest::details::detached_leaf_ptr forest::details::LeafRecord::val()
 	if(eof()){
 		throw TreeException(TreeException::ERRORS::ACCESSING_END_LEAF);
 	}
+	if(detached){
+		return detached_leaf_ptr(new detached_leaf(d_val));
+	}
 	return detached_leaf_ptr(new detached_leaf(it->second));
 }
 
@@ -49,5 +98,17 @@ forest::details::string forest::details::LeafRecord::key()
 	if(eof()){
 		throw TreeException(TreeException::ERRORS::ACCESSING_END_LEAF);
 	}
+	if(detached){
+		return d_key;
+	}
 	return it->first;
 }
+
+bool forest::details::LeafRecord::attach()
+{
+	// Position iterator at the record key or right after it if it was removed
+	it = tree->get_tree()->lower_bound(d_key);
+	detached = false;
+	d_val = nullptr;
+	return !it.expired() && it->first == d_key;
+}
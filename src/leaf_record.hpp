@@ -5,6 +5,7 @@
 #include "dbutils.hpp"
 #include "tree.hpp"
 #include "detached_leaf.hpp"
+#include "snapshot.hpp"
 
 namespace forest{
 namespace details{
@@ -14,6 +15,8 @@ namespace details{
 		public:
 			LeafRecord();
 			LeafRecord(tree_t::iterator it, tree_ptr tree);
+			LeafRecord(tree_t::key_type key, tree_t::val_type val, tree_ptr tree);
+			LeafRecord(tree_t::key_type key, tree_t::val_type val, snapshot_ptr snap, snapshot::position s_pos = snapshot::position());
 			virtual ~LeafRecord();
 			
 			bool eof();
@@ -22,8 +25,20 @@ namespace details{
 			detached_leaf_ptr val();
 			string key();
 		private:
+			bool attach();
+			
 			tree_t::iterator it;
 			tree_ptr tree;
+			
+			// Detached record found by a batch search,
+			// turns into iterator once moved
+			bool detached = false;
+			tree_t::key_type d_key;
+			tree_t::val_type d_val;
+			
+			// Record of the snapshot, moves through the snapshot and never attaches
+			snapshot_ptr snap;
+			snapshot::position s_pos;
 	};
 	
 	using LeafRecord_ptr = std::shared_ptr<LeafRecord>;
@@ -9,6 +9,7 @@ namespace details{
 	// General Lock for Node
 	void lock_read(tree_t::node_ptr& node);
 	void lock_read(tree_t::Node* node);
+	bool try_lock_read(tree_t::node_ptr& node);
 	void unlock_read(tree_t::node_ptr& node);
 	void unlock_read(tree_t::Node* node);
 	void lock_write(tree_t::node_ptr& node);
@@ -50,7 +51,9 @@ namespace details{
 	void change_unlock_write(tree_t::node_ptr& node);
 	void change_unlock_write(tree_t::Node* node);
 	void change_lock_type(tree_t::node_ptr& node, tree_t::PROCESS_TYPE type);
+	void change_lock_type(tree_t::Node* node, tree_t::PROCESS_TYPE type);
 	void change_unlock_type(tree_t::node_ptr& node, tree_t::PROCESS_TYPE type);
+	void change_unlock_type(tree_t::Node* node, tree_t::PROCESS_TYPE type);
 	void change_lock_promote(tree_t::node_ptr& node);
 	void change_lock_promote(tree_t::Node* node);
 	
@@ -76,6 +79,22 @@ inline void forest::details::lock_read(tree_t::Node* node)
 	tl.m.unlock();
 }
 
+inline bool forest::details::try_lock_read(tree_t::node_ptr& node)
+{
+	// Does not wait for writers nor for readers waiting for them
+	auto& tl = get_data(node).travel_locks;
+	
+	if(!tl.m.try_lock()){
+		return false;
+	}
+	bool locked = tl.c > 0 || tl.g.try_lock();
+	if(locked){
+		tl.c++;
+	}
+	tl.m.unlock();
+	return locked;
+}
+
 inline void forest::details::unlock_read(tree_t::node_ptr& node)
 {
 	unlock_read(node.get());
@@ -228,11 +247,21 @@ inline void forest::details::change_unlock_write(tree_t::Node* node)
 }
 
 inline void forest::details::change_lock_type(tree_t::node_ptr& node, tree_t::PROCESS_TYPE type)
+{
+	change_lock_type(node.get(), type);
+}
+
+inline void forest::details::change_lock_type(tree_t::Node* node, tree_t::PROCESS_TYPE type)
 {
 	(type == tree_t::PROCESS_TYPE::WRITE) ? change_lock_write(node) : change_lock_read(node);
 }
 
 inline void forest::details::change_unlock_type(tree_t::node_ptr& node, tree_t::PROCESS_TYPE type)
+{
+	change_unlock_type(node.get(), type);
+}
+
+inline void forest::details::change_unlock_type(tree_t::Node* node, tree_t::PROCESS_TYPE type)
 {
 	(type == tree_t::PROCESS_TYPE::WRITE) ? change_unlock_write(node) : change_unlock_read(node);
 }
@@ -8,6 +8,8 @@
 namespace forest{
 namespace details{
 	
+	class vfile;
+	
 	struct node_addition{
 		struct{
 			std::mutex m,g;
@@ -27,7 +29,7 @@ namespace details{
 			bool shared_lock = false;
 		} change_locks;
 		std::shared_ptr<void> drive_data;
-		std::shared_ptr<DBFS::File> f;
+		std::shared_ptr<vfile> f;
 		std::weak_ptr<void> original;
 		bool bloomed = true;
 		bool is_original = false;
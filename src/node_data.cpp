@@ -13,12 +13,17 @@ forest::details::node_data_ptr forest::details::create_node_data(bool ghost, str
 	return p;
 }
 
-forest::details::node_data_ptr forest::details::get_node_data(tree_t::node_ptr node)
+forest::details::node_data_ptr forest::details::get_node_data(const tree_t::node_ptr& node)
 {
 	return std::static_pointer_cast<node_data_t>(get_data(node).drive_data);
 }
 
-void forest::details::set_node_data(tree_t::node_ptr node, node_data_ptr d)
+forest::details::node_data_t* forest::details::node_data(tree_t::Node* node)
+{
+	return static_cast<node_data_t*>(get_data(node).drive_data.get());
+}
+
+void forest::details::set_node_data(const tree_t::node_ptr& node, node_data_ptr d)
 {
 	set_node_data(node.get(), d);
 }
@@ -28,7 +33,7 @@ void forest::details::set_node_data(tree_t::Node* node, node_data_ptr d)
 	get_data(node).drive_data = d;
 }
 
-bool forest::details::has_data(tree_t::node_ptr node)
+bool forest::details::has_data(const tree_t::node_ptr& node)
 {
 	return has_data(node.get());
 }
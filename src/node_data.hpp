@@ -8,11 +8,15 @@ namespace details{
 	
 	extern const string LEAF_NULL;
 	
+	struct key_index_t;
+	
 	struct node_data_t {
 		bool ghost = true;
 		string path = "";
 		string prev = LEAF_NULL;
 		string next = LEAF_NULL;
+		std::atomic<int_t> count{-1}; // Number of leafs in the subtree, -1 if unknown
+		std::shared_ptr<const key_index_t> key_index; // Packed keys, built on read or search
 		node_data_t(bool ghost, string path) : ghost(ghost), path(path) {};
 	};
 	
@@ -21,10 +25,11 @@ namespace details{
 	// Node data
 	node_data_ptr create_node_data(bool ghost, string path);
 	node_data_ptr create_node_data(bool ghost, string path, string prev, string next);
-	node_data_ptr get_node_data(tree_t::node_ptr node);
-	void set_node_data(tree_t::node_ptr node, node_data_ptr d);
+	node_data_ptr get_node_data(const tree_t::node_ptr& node);
+	node_data_t* node_data(tree_t::Node* node);
+	void set_node_data(const tree_t::node_ptr& node, node_data_ptr d);
 	void set_node_data(tree_t::Node* node, node_data_ptr d);
-	bool has_data(tree_t::node_ptr node);
+	bool has_data(const tree_t::node_ptr& node);
 	bool has_data(tree_t::Node* node);
 
 } // details
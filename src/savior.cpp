@@ -187,11 +187,8 @@ void forest::details::Savior::save_item(save_key item)
 			node_data_ptr data = get_node_data(node);
 			string cur_name = data->path;
 		
-			file_ptr cur_f = get_data(node).f;
+			vfile_ptr cur_f = get_data(node).f;
 			if(cur_f){
-				// Update count of opened files to not exceed the limit
-				forest::details::opened_files_inc();
-				auto locked = cur_f->get_lock();
 				cur_f->move(DBFS::random_filename());
 				
 				// Other could still reference this leaf, so delete file
@@ -199,14 +196,12 @@ void forest::details::Savior::save_item(save_key item)
 				lazy_delete_file(cur_f);
 			}
 			
-			file_ptr fp = file_ptr(new DBFS::File(cur_name));
+			vfile_ptr fp = vfile_ptr(new vfile(cur_name));
 			get_data(node).f = fp;
 			forest::details::Tree::save_leaf(node, fp);
 		} else { // REMOVE
-			file_ptr cur_f = get_data(node).f;
+			vfile_ptr cur_f = get_data(node).f;
 			if(cur_f){
-				opened_files_inc();
-				
 				// Same as for saving
 				lazy_delete_file(cur_f);
 			}
@@ -356,11 +351,9 @@ void forest::details::Savior::pop_item(save_key& item)
 	}
 }
 
-void forest::details::Savior::lazy_delete_file(file_ptr f)
+void forest::details::Savior::lazy_delete_file(vfile_ptr f)
 {
-	f->on_close([this](DBFS::File* file){
-		// preserve limit
-		forest::details::opened_files_dec();
+	f->on_close([this](vfile* file){
 		remove_file_async(file->name());
 	});
 }
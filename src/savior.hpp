@@ -14,8 +14,6 @@ namespace forest{
 namespace details{
 	
 	extern std::atomic<int> opened_files_count;
-	extern std::mutex opened_files_m;
-	extern std::condition_variable opened_files_cv;
 	
 	extern int SCHEDULE_TIMER;
 	extern int SAVIOUR_QUEUE_LENGTH;
@@ -54,7 +52,7 @@ namespace details{
 			save_value* get_item(save_key& item);
 			save_value* lock_item(save_key& item);
 			void pop_item(save_key& item);
-			void lazy_delete_file(file_ptr f);
+			void lazy_delete_file(vfile_ptr f);
 			bool has(save_key& item);
 			bool has_locking(save_key& item);
 			void lock_map();
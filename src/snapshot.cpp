@@ -0,0 +1,155 @@
+#include "snapshot.hpp"
+
+forest::details::snapshot::snapshot(tree_owner_ptr owner) : owner(owner), tree(extract_native_tree(owner))
+{
+	tree->add_snapshot(this);
+}
+
+forest::details::snapshot::~snapshot()
+{
+	// Pre-images are released with the snapshot
+	tree->remove_snapshot(this);
+}
+
+forest::details::tree_ptr forest::details::snapshot::get_tree()
+{
+	return tree;
+}
+
+bool forest::details::snapshot::get(tree_t::key_type key, tree_t::val_type& val)
+{
+	tree_t* t = tree->get_tree();
+	tree_t::val_type live;
+	{
+		auto it = t->find(key);
+		if(it != t->end()){
+			live = it->second->snapshot();
+		}
+	}
+	
+	// Checked after reading, as writers capture before changing
+	std::lock_guard<mutex> lock(m);
+	auto pit = preimages.find(key);
+	val = (pit != preimages.end()) ? pit->second : live;
+	return (bool)val;
+}
+
+bool forest::details::snapshot::seek(position& p, const tree_t::key_type* pos, bool inclusive, bool forward, tree_t::key_type& key, tree_t::val_type& val)
+{
+	p.keys.clear();
+	p.vals.clear();
+	p.index = 0;
+	p.forward = forward;
+	p.loaded = true;
+	p.edge = !pos;
+	if(pos){
+		p.next = *pos;
+	}
+	p.inclusive = inclusive;
+	p.more = true;
+	
+	return next(p, pos, inclusive, key, val);
+}
+
+bool forest::details::snapshot::move(position& p, bool forward, tree_t::key_type& key, tree_t::val_type& val)
+{
+	// Moves from `key`, the buffer is read again only when the direction changes
+	tree_t::key_type from = key;
+	if(!p.loaded || p.forward != forward){
+		return seek(p, &from, false, forward, key, val);
+	}
+	return next(p, &from, false, key, val);
+}
+
+bool forest::details::snapshot::next(position& p, const tree_t::key_type* from, bool inclusive, tree_t::key_type& key, tree_t::val_type& val)
+{
+	// Nearest live record that was not changed after the snapshot
+	while(p.index == p.keys.size() && p.more){
+		fill(p);
+	}
+	bool has_live = p.index < p.keys.size();
+	
+	// Nearest pre-image of the record that existed at the snapshot time
+	std::unique_lock<mutex> lock(m);
+	bool has_pre = false;
+	auto pit = preimages.end();
+	if(p.forward){
+		pit = !from ? preimages.begin() : (inclusive ? preimages.lower_bound(*from) : preimages.upper_bound(*from));
+		while(pit != preimages.end() && !pit->second){
+			++pit;
+		}
+		has_pre = pit != preimages.end() && (!has_live || !(p.keys[p.index] < pit->first));
+	} else {
+		auto rit = !from ? preimages.end() : (inclusive ? preimages.upper_bound(*from) : preimages.lower_bound(*from));
+		while(rit != preimages.begin()){
+			--rit;
+			if(rit->second){
+				pit = rit;
+				break;
+			}
+		}
+		has_pre = pit != preimages.end() && (!has_live || !(pit->first < p.keys[p.index]));
+	}
+	
+	if(has_pre){
+		key = pit->first;
+		val = pit->second;
+		// Record captured after its leaf was read is the same one
+		if(has_live && !(key < p.keys[p.index]) && !(p.keys[p.index] < key)){
+			p.index++;
+		}
+		return true;
+	}
+	lock.unlock();
+	
+	if(!has_live){
+		return false;
+	}
+	key = p.keys[p.index];
+	val = p.vals[p.index];
+	p.index++;
+	return true;
+}
+
+void forest::details::snapshot::fill(position& p)
+{
+	p.keys.clear();
+	p.vals.clear();
+	p.index = 0;
+	p.more = tree->scan_leaf(p.next, p.inclusive, p.keys, p.vals, p.forward, p.edge);
+	p.edge = false;
+	if(!p.forward){
+		std::reverse(p.keys.begin(), p.keys.end());
+		std::reverse(p.vals.begin(), p.vals.end());
+	}
+	
+	// Records changed before the leaf was read are taken from the pre-images.
+	// Later changes are captured with the same values the leaf has
+	std::lock_guard<mutex> lock(m);
+	uint_t c = 0;
+	for(uint_t i=0;i<p.keys.size();i++){
+		if(preimages.count(p.keys[i])){
+			continue;
+		}
+		if(c != i){
+			p.keys[c] = std::move(p.keys[i]);
+			p.vals[c] = std::move(p.vals[i]);
+		}
+		c++;
+	}
+	p.keys.resize(c);
+	p.vals.resize(c);
+}
+
+bool forest::details::snapshot::captured(const tree_t::key_type& key)
+{
+	std::lock_guard<mutex> lock(m);
+	return preimages.count(key);
+}
+
+void forest::details::snapshot::capture(const tree_t::key_type& key, tree_t::val_type val)
+{
+	std::lock_guard<mutex> lock(m);
+	// The first captured value is the one at the snapshot time
+	preimages.emplace(key, val);
+}
@@ -0,0 +1,57 @@
+#ifndef FOREST_SNAPSHOT_H
+#define FOREST_SNAPSHOT_H
+
+#include <map>
+#include <vector>
+#include "dbutils.hpp"
+#include "tree.hpp"
+#include "tree_owner.hpp"
+
+namespace forest{
+namespace details{
+	
+	class snapshot{
+		
+		public:
+			// Live records of one leaf read ahead in the direction of the moves
+			struct position{
+				std::vector<tree_t::key_type> keys;
+				std::vector<tree_t::val_type> vals;
+				uint_t index = 0;
+				bool forward = true;
+				bool loaded = false;
+				// Start of the next leaf
+				tree_t::key_type next;
+				bool inclusive = true;
+				bool edge = true;
+				bool more = true;
+			};
+			
+			snapshot(tree_owner_ptr owner);
+			virtual ~snapshot();
+			
+			tree_ptr get_tree();
+			bool get(tree_t::key_type key, tree_t::val_type& val);
+			bool seek(position& p, const tree_t::key_type* pos, bool inclusive, bool forward, tree_t::key_type& key, tree_t::val_type& val);
+			bool move(position& p, bool forward, tree_t::key_type& key, tree_t::val_type& val);
+			
+			bool captured(const tree_t::key_type& key);
+			void capture(const tree_t::key_type& key, tree_t::val_type val);
+			
+		private:
+			bool next(position& p, const tree_t::key_type* from, bool inclusive, tree_t::key_type& key, tree_t::val_type& val);
+			void fill(position& p);
+			
+			tree_owner_ptr owner;
+			tree_ptr tree;
+			
+			// Values of the keys changed after the snapshot was taken,
+			// nullptr for the keys that did not exist
+			std::map<tree_t::key_type, tree_t::val_type> preimages;
+			mutex m;
+	};
+	
+} // details
+} // forest
+
+#endif // FOREST_SNAPSHOT_H
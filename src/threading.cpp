@@ -71,6 +71,11 @@ bool forest::Thread_worker::is_busy(){
 	return busy; 
 }
 
+std::size_t forest::Thread_worker::get_load(){
+	auto lock = get_lock();
+	return q.size() + (busy ? 1 : 0);
+}
+
 void forest::Thread_worker::notify(){ 
 	cv.notify_all(); 
 }
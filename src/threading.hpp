@@ -44,6 +44,7 @@ namespace forest{
 			void work(work_fn f);
 			void wait();
 			bool is_busy();
+			std::size_t get_load();
 		
 		private:
 			void notify();
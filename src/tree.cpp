@@ -1,4 +1,141 @@
 #include "tree.hpp"
+#include "snapshot.hpp"
+
+namespace forest{
+namespace details{
+	
+	// Leaf count changes made by the current thread
+	thread_local int_t count_delta = 0;
+	thread_local bool count_restructured = false;
+	thread_local bool count_tracking = false;
+	
+	// Nodes split, joined, shifted or changed by the current thread,
+	// their counts are summed again from the children
+	thread_local std::vector<tree_t::Node*> count_nodes;
+	
+	// Leafs split or shifted by the current thread, the separator between them is truncated
+	thread_local tree_t::Node* split_left = nullptr;
+	thread_local tree_t::Node* split_right = nullptr;
+	
+	// Last leaf entered by the current thread, found keys are indexed to it
+	thread_local string hash_leaf;
+	
+	// Key searched by the current thread, leafs whose filter excludes it are not read
+	thread_local const tree_t::key_type* bloom_key = nullptr;
+	thread_local tree_t::Node* bloom_skipped = nullptr;
+	
+	// Filters are kept for up to this many leafs per cached leaf
+	const int BLOOM_CACHE_SHARE = 64;
+	
+	// Keys erased by a range removal at once
+	const uint_t RANGE_CHUNK = 1024;
+	
+	// Cuts the next whitespace separated token from the head
+	bool next_token(std::string_view& head, std::string_view& token)
+	{
+		uint_t i = 0;
+		while(i < head.size() && std::isspace((unsigned char)head[i])){
+			i++;
+		}
+		uint_t j = i;
+		while(j < head.size() && !std::isspace((unsigned char)head[j])){
+			j++;
+		}
+		token = head.substr(i, j - i);
+		head.remove_prefix(j);
+		return i < j;
+	}
+	
+	template<class T>
+	bool next_number(std::string_view& head, T& value)
+	{
+		std::string_view token;
+		if(!next_token(head, token)){
+			return false;
+		}
+		auto res = std::from_chars(token.data(), token.data() + token.size(), value);
+		return res.ec == std::errc() && res.ptr == token.data() + token.size();
+	}
+	
+	// Same as next_token, but the token must be on the current line
+	bool next_line_token(std::string_view& head, std::string_view& token)
+	{
+		uint_t i = 0;
+		while(i < head.size() && (head[i] == ' ' || head[i] == '\t')){
+			i++;
+		}
+		head.remove_prefix(i);
+		if(head.empty() || std::isspace((unsigned char)head[0])){
+			token = head.substr(0, 0);
+			return false;
+		}
+		return next_token(head, token);
+	}
+	
+	// Shortest prefix of the right key that is still greater than the left one
+	tree_t::key_type separator_prefix(const tree_t::key_type& left, const tree_t::key_type& right)
+	{
+		uint_t i = 0;
+		uint_t sz = std::min(left.size(), right.size());
+		while(i < sz && left[i] == right[i]){
+			i++;
+		}
+		return right.substr(0, std::min<uint_t>(i+1, right.size()));
+	}
+	
+	// Key formats of the node files
+	const int KEYS_PLAIN = 0;
+	const int KEYS_FRONT_CODED = 1;
+	
+	// Front coded keys are written as "<shared>:<suffix>", where shared is
+	// the length of the prefix equal to the previous key. Every KEY_RESTART-th
+	// key is written whole, so a broken key does not spoil the rest.
+	const uint_t KEY_RESTART = 16;
+	
+	void write_keys(std::ostream& ss, const std::vector<tree_t::key_type>& keys, int format)
+	{
+		if(format != KEYS_FRONT_CODED){
+			for(auto& key : keys){
+				ss << key << " ";
+			}
+			return;
+		}
+		uint_t c = keys.size();
+		for(uint_t i=0;i<c;i++){
+			const tree_t::key_type& key = keys[i];
+			uint_t shared = 0;
+			if(i % KEY_RESTART){
+				const tree_t::key_type& prev = keys[i-1];
+				uint_t sz = std::min(prev.size(), key.size());
+				while(shared < sz && prev[shared] == key[shared]){
+					shared++;
+				}
+			}
+			ss << shared << ":";
+			ss.write(key.data() + shared, key.size() - shared);
+			ss << " ";
+		}
+	}
+	
+	// Key holds the previous key and is replaced with the decoded one
+	bool front_decode(std::string_view token, tree_t::key_type& key)
+	{
+		auto sep = token.find(':');
+		if(sep == std::string_view::npos){
+			return false;
+		}
+		uint_t shared;
+		auto res = std::from_chars(token.data(), token.data() + sep, shared);
+		if(res.ec != std::errc() || res.ptr != token.data() + sep || shared > key.size()){
+			return false;
+		}
+		key.resize(shared);
+		key.append(token.data() + sep + 1, token.size() - sep - 1);
+		return true;
+	}
+	
+} // details
+} // forest
 
 forest::details::Tree::Tree(string path)
 {	
@@ -7,6 +144,7 @@ forest::details::Tree::Tree(string path)
 	
 	type = base.type;
 	annotation = base.annotation;
+	set_options(base);
 	
 	// Init BPT
 	tree = new tree_t(base.factor, create_node(base.branch, base.branch_type), base.count, this);
@@ -23,6 +161,7 @@ forest::details::Tree::Tree(string path, TREE_TYPES type, int factor, string ann
 	name = path;
 	this->type = type;
 	this->annotation = annotation;
+	this->factor = factor;
 	
 	// Init BPT
 	tree = new tree_t(factor, create_node(LEAF_NULL, NODE_TYPES::LEAF), 0, this);
@@ -79,59 +218,1389 @@ forest::details::tree_ptr forest::details::Tree::get(string path)
 	// Read Tree data
 	tree_base_read_t base = read_base(path);
 	
-	// Fill tree
-	t->set_name(path);
-	t->set_type(base.type);
-	t->set_annotation(base.annotation);
+	// Fill tree
+	t->set_name(path);
+	t->set_type(base.type);
+	t->set_annotation(base.annotation);
+	t->set_options(base);
+	
+	// Init BPT
+	t->set_tree(new tree_t(base.factor, create_node(base.branch, base.branch_type), base.count, t.get()));
+	
+	cache::tree_cache_m.lock();
+	
+	cache::tree_cache.push(path, t);
+	cache::tree_cache_r[path].second--;
+	t->unlock();
+
+	// return value
+	return t;
+}
+
+forest::details::tree_t* forest::details::Tree::get_tree()
+{
+	return this->tree;
+}
+
+void forest::details::Tree::set_tree(tree_t* tree)
+{
+	this->tree = tree;
+}
+
+void forest::details::Tree::insert(tree_t::key_type key, tree_t::val_type val, bool update)
+{
+	if(!valid_key(type, key)){
+		throw TreeException(TreeException::ERRORS::BAD_INPUT_PARAMETER);
+	}
+	std::shared_lock<std::shared_mutex> lock(batch_m);
+	insert_item(key, std::move(val), update);
+	tree->save_base();
+}
+
+void forest::details::Tree::erase(tree_t::key_type key)
+{
+	std::shared_lock<std::shared_mutex> lock(batch_m);
+	erase_item(key);
+	tree->save_base();
+}
+
+forest::details::uint_t forest::details::Tree::erase_range(tree_t::key_type from, tree_t::key_type to)
+{
+	std::unique_lock<std::shared_mutex> lock(batch_m);
+	
+	// Covered leafs are dropped as a whole, the rest is erased by keys
+	uint_t count = 0;
+	if(from < to){
+		count = detach_range(from, to);
+	}
+	
+	// Keys are collected by chunks, so the iterator does not hold any leaf
+	// while erasing and memory does not grow with the range
+	std::vector<tree_t::key_type> keys;
+	keys.reserve(RANGE_CHUNK);
+	tree_t::key_type pos = from;
+	do{
+		keys.clear();
+		{
+			auto it = tree->lower_bound(pos);
+			auto end = tree->end();
+			while(it != end && it->first < to && keys.size() < RANGE_CHUNK){
+				keys.push_back(it->first);
+				++it;
+			}
+		}
+		
+		// Emptied nodes are removed by the Savior asynchronously
+		for(auto& key : keys){
+			erase_item(key);
+		}
+		count += keys.size();
+		
+		// Keys before pos are erased already
+		if(keys.size()){
+			pos = keys.back();
+		}
+	} while(keys.size() == RANGE_CHUNK);
+	
+	if(count){
+		tree->save_base();
+	}
+	
+	return count;
+}
+
+forest::details::tree_t::iterator forest::details::Tree::find(tree_t::key_type key)
+{
+	std::shared_lock<std::shared_mutex> lock(batch_m);
+	if(hash_index){
+		hash_leaf.clear();
+	}
+	bloom_key = bloom_bits ? &key : nullptr;
+	tree_t::iterator it;
+	try{
+		it = tree->find(key);
+	} catch(...){
+		bloom_key = nullptr;
+		throw;
+	}
+	bloom_key = nullptr;
+	if(it == tree->end()){
+		throw TreeException(TreeException::ERRORS::LEAF_DOES_NOT_EXISTS);
+	}
+	if(hash_index && hash_leaf.size()){
+		hash_put(hash_leaf, key);
+	}
+	return it;
+}
+
+bool forest::details::Tree::hash_find(const tree_t::key_type& key, tree_t::val_type& val)
+{
+	// Returns false if the key has to be searched through the tree
+	if(!hash_index){
+		return false;
+	}
+	
+	std::shared_lock<std::shared_mutex> lock(batch_m);
+	
+	string path;
+	{
+		hash_shard& shard = get_hash_shard(key);
+		std::shared_lock<std::shared_mutex> h_lock(shard.m);
+		auto it = shard.map.find(key);
+		if(it != shard.map.end()){
+			path = it->second;
+		}
+	}
+	// Missing or stale entries and uncached leafs go through the tree,
+	// which indexes the key once it is found there
+	return path.size() && hash_read(path, key, val);
+}
+
+forest::details::tree_t::iterator forest::details::Tree::find(LEAF_POSITION position)
+{
+	std::shared_lock<std::shared_mutex> lock(batch_m);
+	if(position == LEAF_POSITION::BEGIN){
+		return tree->begin();
+	} else if(position == LEAF_POSITION::END) {
+		return --tree->end();
+	}
+	throw TreeException(TreeException::ERRORS::BAD_INPUT_PARAMETER);
+}
+
+forest::details::tree_t::iterator forest::details::Tree::find(tree_t::key_type key, LEAF_POSITION position)
+{
+	std::shared_lock<std::shared_mutex> lock(batch_m);
+	if(position == LEAF_POSITION::LOWER){
+		return tree->lower_bound(key);
+	} else if(position == LEAF_POSITION::UPPER) {
+		return tree->upper_bound(key);
+	}
+	throw TreeException(TreeException::ERRORS::BAD_INPUT_PARAMETER);
+}
+
+void forest::details::Tree::batch_lock()
+{
+	batch_m.lock();
+}
+
+void forest::details::Tree::batch_unlock()
+{
+	batch_m.unlock();
+}
+
+void forest::details::Tree::add_snapshot(snapshot* snap)
+{
+	// Wait for the writers in progress, so every later change is captured
+	std::unique_lock<std::shared_mutex> lock(batch_m);
+	std::unique_lock<std::shared_mutex> s_lock(snapshots_m);
+	snapshots.push_back(snap);
+}
+
+void forest::details::Tree::remove_snapshot(snapshot* snap)
+{
+	std::unique_lock<std::shared_mutex> lock(snapshots_m);
+	snapshots.erase(std::find(snapshots.begin(), snapshots.end(), snap));
+}
+
+void forest::details::Tree::prepare_batch(std::vector<batch_op_t>& ops)
+{
+	// Expects batch_lock to be held by the caller
+	// Stable sort keeps the order of mutations with the same key
+	std::stable_sort(ops.begin(), ops.end(), [](const batch_op_t& a, const batch_op_t& b){
+		return a.key < b.key;
+	});
+	
+	std::vector<tree_t::key_type> keys;
+	for(auto& op : ops){
+		if(keys.empty() || keys.back() < op.key){
+			keys.push_back(op.key);
+		}
+	}
+	
+	bool capturing;
+	{
+		std::shared_lock<std::shared_mutex> lock(snapshots_m);
+		capturing = snapshots.size();
+	}
+	
+	// One sorted descent finds the existing keys and their values before the batch
+	std::vector<char> exists(keys.size(), false);
+	std::vector<tree_t::val_type> vals(keys.size());
+	visit_batch(keys, [&exists, &vals, capturing](uint_t i, tree_t::val_type& val){
+		exists[i] = true;
+		if(capturing){
+			vals[i] = val->snapshot();
+		}
+	});
+	
+	// Mutations of the same key are folded into one, so every key is changed
+	// by a single descent. Inserts of existing keys and removes of missing ones
+	// change nothing, they are dropped before any change so no operation fails halfway
+	std::vector<batch_op_t> kept;
+	kept.reserve(keys.size());
+	uint_t i = 0;
+	for(uint_t k=0;k<keys.size();k++){
+		bool existed = exists[k];
+		bool present = existed;
+		bool changed = false;
+		tree_t::val_type val;
+		for(; i < ops.size() && !(keys[k] < ops[i].key); i++){
+			batch_op_t& op = ops[i];
+			if(op.type == BATCH_OPS::REMOVE){
+				present = false;
+				changed = false;
+			} else if(!present || op.type == BATCH_OPS::UPDATE){
+				present = true;
+				changed = true;
+				val = std::move(op.val);
+			}
+		}
+		if(present && changed){
+			kept.push_back({existed ? BATCH_OPS::UPDATE : BATCH_OPS::INSERT, keys[k], std::move(val)});
+		} else if(!present && existed){
+			kept.push_back({BATCH_OPS::REMOVE, keys[k], nullptr});
+		} else {
+			continue;
+		}
+		
+		// Values before the batch are already known, writers do not search for them
+		if(capturing){
+			std::shared_lock<std::shared_mutex> lock(snapshots_m);
+			for(auto* snap : snapshots){
+				snap->capture(keys[k], vals[k]);
+			}
+		}
+	}
+	ops.swap(kept);
+}
+
+void forest::details::Tree::apply_batch(std::vector<batch_op_t>& ops)
+{
+	// Expects batch_lock to be held and the ops to be prepared.
+	// Every key has a single op, sorted keys make it
+	// reuse the path and leafs that are already in cache
+	try{
+		for(auto& op : ops){
+			if(op.type == BATCH_OPS::REMOVE){
+				erase_item(op.key);
+			} else {
+				insert_item(op.key, op.val, op.type == BATCH_OPS::UPDATE);
+			}
+		}
+	} catch(...){
+		// Base keeps the count of the applied part
+		tree->save_base();
+		throw;
+	}
+	
+	// Base file is saved once per batch
+	if(ops.size()){
+		tree->save_base();
+	}
+}
+
+void forest::details::Tree::find_batch(const std::vector<tree_t::key_type>& keys, std::vector<tree_t::val_type>& vals)
+{
+	// Keys are expected to be sorted
+	vals.assign(keys.size(), nullptr);
+	
+	std::shared_lock<std::shared_mutex> lock(batch_m);
+	
+	// Copies of the batch share one allocation, which lives while any of them is held
+	block_allocator<file_data_t> alloc(std::make_shared<file_data_block>(keys.size()));
+	visit_batch(keys, [&vals, &alloc](uint_t i, tree_t::val_type& val){
+		// Copy the value so it is not affected by further leaf changes
+		vals[i] = val->snapshot(alloc);
+	});
+}
+
+
+forest::details::uint_t forest::details::Tree::count_range(tree_t::key_type from, tree_t::key_type to)
+{
+	if(!(from < to)){
+		return 0;
+	}
+	
+	std::shared_lock<std::shared_mutex> lock(batch_m);
+	
+	int_t c = count_search([this, &from, &to](tree_t::node_ptr& root, bool recount){
+		int_t before_from = count_less(root, from, recount);
+		if(before_from < 0){
+			return before_from;
+		}
+		int_t before_to = count_less(root, to, recount);
+		if(before_to < 0){
+			return before_to;
+		}
+		return before_to - before_from;
+	});
+	
+	return c < 0 ? 0 : c;
+}
+
+forest::details::tree_t::iterator forest::details::Tree::find_at(uint_t index)
+{
+	std::shared_lock<std::shared_mutex> lock(batch_m);
+	
+	tree_t::key_type key;
+	int_t found = count_search([this, index, &key](tree_t::node_ptr& root, bool recount){
+		return key_at(root, index, key, recount);
+	});
+	
+	if(found <= 0){
+		return tree->end();
+	}
+	
+	// End leaf if the key is already removed by concurrent writer
+	return tree->find(key);
+}
+
+
+std::vector<forest::details::tree_t::key_type> forest::details::Tree::split_range(tree_t::key_type from, tree_t::key_type to, int parts)
+{
+	std::vector<tree_t::key_type> keys;
+	if(parts < 2 || !(from < to)){
+		return keys;
+	}
+	
+	std::shared_lock<std::shared_mutex> lock(batch_m);
+	tree->lock_read();
+	
+	tree_t::node_ptr root = tree->get_root_pub();
+	
+	try{
+		// Go one level deeper until there are enough separators inside of the range
+		bool deeper = has_data(root);
+		for(int depth=0; deeper && (int)keys.size() < parts-1; depth++){
+			keys.clear();
+			deeper = collect_separators(root, from, to, depth, keys);
+		}
+	} catch(...){
+		tree->unlock_read();
+		throw;
+	}
+	
+	tree->unlock_read();
+	
+	// Pick evenly spaced separators, subtrees of the same level hold similar number of leafs
+	if((int)keys.size() > parts-1){
+		std::vector<tree_t::key_type> picked;
+		for(int i=1;i<parts;i++){
+			picked.push_back(keys[keys.size()*i/parts]);
+		}
+		picked.erase(std::unique(picked.begin(), picked.end()), picked.end());
+		keys.swap(picked);
+	}
+	
+	return keys;
+}
+
+
+bool forest::details::Tree::bloom_excludes(tree_t::Node* leaf, const tree_t::key_type& key)
+{
+	if(!has_data(leaf)){
+		return false;
+	}
+	string path = node_data(leaf)->path;
+	std::lock_guard<std::mutex> lock(blooms_m);
+	return leaf_blooms.has(path) && !leaf_blooms.get(path)->may_contain(key);
+}
+
+bool forest::details::Tree::bloom_skips(tree_t::node_ptr& node, const std::vector<tree_t::key_type>& keys, uint_t from, uint_t to)
+{
+	// Leaf is not read if its filter excludes every key
+	if(!bloom_bits || !node->is_leaf()){
+		return false;
+	}
+	for(uint_t i=from;i<to;i++){
+		if(!bloom_excludes(node.get(), keys[i])){
+			return false;
+		}
+	}
+	skipped_leafs++;
+	return true;
+}
+
+bool forest::details::Tree::bloom_skip(tree_t::node_ptr& node)
+{
+	// Leaf that is not materialized by anyone gets empty items instead of being read,
+	// it is held exclusively until the search leaves it
+	lock_write(node);
+	own_lock(node);
+	bool skip = !get_data(node).owner_locks.c && bloom_excludes(node.get(), *bloom_key);
+	if(skip){
+		static thread_local tree_t::node_ptr empty(new tree_t::LeafNode());
+		node->set_childs(empty->get_childs());
+		bloom_skipped = node.get();
+		skipped_leafs++;
+	}
+	own_unlock(node);
+	if(!skip){
+		unlock_write(node);
+	}
+	return skip;
+}
+
+void forest::details::Tree::bloom_build(const string& path, const std::vector<tree_t::key_type>& keys)
+{
+	auto filter = std::make_shared<bloom_filter>(keys.size(), bloom_bits);
+	for(auto& key : keys){
+		filter->add(key);
+	}
+	string p = path;
+	std::lock_guard<std::mutex> lock(blooms_m);
+	// Filters are a small part of a leaf, so they outlive the cached leafs
+	// but are bounded by the cache as well
+	leaf_blooms.resize(LEAF_CACHE_LENGTH * BLOOM_CACHE_SHARE);
+	leaf_blooms.remove(p);
+	leaf_blooms.push(p, filter);
+}
+
+void forest::details::Tree::bloom_add(tree_t::Node* leaf, const tree_t::key_type& key)
+{
+	if(!has_data(leaf)){
+		return;
+	}
+	string path = node_data(leaf)->path;
+	std::lock_guard<std::mutex> lock(blooms_m);
+	if(leaf_blooms.has(path)){
+		leaf_blooms.get(path)->add(key);
+	}
+}
+
+void forest::details::Tree::bloom_drop(tree_t::Node* leaf)
+{
+	// Filter is built again when the leaf is read next time
+	if(!has_data(leaf)){
+		return;
+	}
+	string path = node_data(leaf)->path;
+	std::lock_guard<std::mutex> lock(blooms_m);
+	leaf_blooms.remove(path);
+}
+
+forest::details::Tree::hash_shard& forest::details::Tree::get_hash_shard(const tree_t::key_type& key)
+{
+	return leaf_hash[std::hash<tree_t::key_type>()(key) % HASH_SHARDS];
+}
+
+bool forest::details::Tree::hash_read(const string& path, const tree_t::key_type& key, tree_t::val_type& val)
+{
+	// Only leafs kept in memory and not changed at the moment are read, others go through the tree.
+	// Read lock keeps writers away from the leaf, held pointer keeps it alive if it is evicted
+	node_ptr n;
+	bool locked = false;
+	
+	cache::leaf_lock();
+	/// lock{
+	auto it = cache::leaf_cache_r.find(path);
+	if(it != cache::leaf_cache_r.end()){
+		n = it->second.first;
+		locked = try_lock_read(n);
+	}
+	/// }lock
+	cache::leaf_unlock();
+	
+	if(!locked){
+		return false;
+	}
+	
+	auto* childs = n->get_childs();
+	auto c_it = childs->find(key);
+	bool found = c_it != childs->end();
+	if(found){
+		// Copy the value so it is not affected by further leaf changes
+		val = c_it->data->item->second->snapshot();
+	}
+	unlock_read(n);
+	
+	return found;
+}
+
+void forest::details::Tree::hash_put(const string& path, const tree_t::key_type& key)
+{
+	if(HASH_INDEX_SIZE <= 0){
+		return;
+	}
+	
+	hash_shard& shard = get_hash_shard(key);
+	
+	// Keys that are already indexed to the leaf are not written again
+	{
+		std::shared_lock<std::shared_mutex> lock(shard.m);
+		auto it = shard.map.find(key);
+		if(it != shard.map.end() && it->second == path){
+			return;
+		}
+	}
+	
+	std::unique_lock<std::shared_mutex> lock(shard.m);
+	auto it = shard.map.find(key);
+	if(it != shard.map.end()){
+		it->second = path;
+		return;
+	}
+	
+	// Shard is full, evict entries bucket by bucket
+	uint_t limit = std::max(HASH_INDEX_SIZE / HASH_SHARDS, 1);
+	while(shard.map.size() >= limit){
+		uint_t b = shard.evict++ % shard.map.bucket_count();
+		if(shard.map.bucket_size(b)){
+			tree_t::key_type evicted = shard.map.begin(b)->first;
+			shard.map.erase(evicted);
+		}
+	}
+	shard.map[key] = path;
+}
+
+void forest::details::Tree::hash_erase(const tree_t::key_type& key)
+{
+	hash_shard& shard = get_hash_shard(key);
+	std::unique_lock<std::shared_mutex> lock(shard.m);
+	shard.map.erase(key);
+}
+
+void forest::details::Tree::truncate_separator(tree_t::node_ptr& node)
+{
+	// Any key between the last key of the left leaf and the first key
+	// of the right one routes the same way, so the shortest one is kept.
+	// Integer keys are left whole for the packed key search.
+	tree_t::Node* a = split_left;
+	tree_t::Node* b = split_right;
+	split_left = split_right = nullptr;
+	if(type != TREE_TYPES::KEY_STRING){
+		return;
+	}
+	
+	auto* nodes = node->get_nodes();
+	auto* keys = node->get_keys();
+	uint_t c = keys->size();
+	for(uint_t i=0;i<c && i+1<nodes->size();i++){
+		tree_t::Node* left = (*nodes)[i].get();
+		tree_t::Node* right = (*nodes)[i+1].get();
+		if(!((left == a && right == b) || (left == b && right == a))){
+			continue;
+		}
+		if(!left->is_leaf() || !right->is_leaf() || !left->get_childs() || !right->get_childs()){
+			return;
+		}
+		auto* l_childs = left->get_childs();
+		auto* r_childs = right->get_childs();
+		if(!l_childs->size() || !r_childs->size()){
+			return;
+		}
+		
+		const tree_t::key_type* last = nullptr;
+		for(auto it = l_childs->begin(); it != l_childs->end(); it = l_childs->find_next(it)){
+			last = &it->data->item->first;
+		}
+		const tree_t::key_type& first = r_childs->begin()->data->item->first;
+		if(*last < first){
+			tree_t::key_type sep = separator_prefix(*last, first);
+			if(sep.size() < (*keys)[i].size()){
+				(*keys)[i] = std::move(sep);
+			}
+		}
+		return;
+	}
+}
+
+forest::details::uint_t forest::details::Tree::child_index(tree_t::node_ptr& node, const tree_t::key_type& key)
+{
+	// Same as upper_bound over the node keys
+	return node_upper_bound(node.get(), key, type != TREE_TYPES::KEY_STRING);
+}
+
+bool forest::details::Tree::scan_leaf(tree_t::key_type& pos, bool& inclusive, std::vector<tree_t::key_type>& keys, std::vector<tree_t::val_type>& vals, bool forward, bool edge)
+{
+	// Returns false if the read leaf is the last one in the direction.
+	// Moving back it reads the records before `pos`, `edge` starts from the end of the tree
+	std::shared_lock<std::shared_mutex> lock(batch_m);
+	
+	bool more = true;
+	while(keys.empty() && more){
+		tree->lock_read();
+		
+		tree_t::node_ptr root = tree->get_root_pub();
+		tree_t::key_type bound;
+		bool bounded = false;
+		
+		try{
+			if(has_data(root)){
+				scan_leaf(root, edge ? nullptr : &pos, inclusive, forward, keys, vals, bound, bounded);
+			}
+		} catch(...){
+			tree->unlock_read();
+			throw;
+		}
+		
+		tree->unlock_read();
+		
+		// Next leaf starts at the nearest separator in the direction
+		more = bounded;
+		if(bounded){
+			pos = bound;
+			inclusive = forward;
+			edge = false;
+		}
+	}
+	
+	return more;
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+
+
+void forest::details::Tree::scan_leaf(tree_t::node_ptr node, const tree_t::key_type* pos, bool inclusive, bool forward, std::vector<tree_t::key_type>& keys, std::vector<tree_t::val_type>& vals, tree_t::key_type& bound, bool& bounded)
+{
+	d_enter(node, tree_t::PROCESS_TYPE::READ);
+	
+	try{
+		if(node->is_leaf()){
+			// Copies of the read records share one allocation for the lifetime of the batch,
+			// so they stay readable after the leaf changes
+			auto* childs = node->get_childs();
+			block_allocator<file_data_t> alloc(std::make_shared<file_data_block>(childs->size()));
+			for(auto it = childs->begin(); it != childs->end(); it = childs->find_next(it)){
+				const tree_t::key_type& key = it->data->item->first;
+				bool in = !pos || (forward ? (inclusive ? !(key < *pos) : *pos < key) : (inclusive ? !(*pos < key) : key < *pos));
+				if(in){
+					keys.push_back(key);
+					vals.push_back(it->data->item->second->snapshot(alloc));
+				}
+			}
+		} else {
+			auto kb = node->keys_iterator();
+			auto ke = node->keys_iterator_end();
+			// Records equal to the separator are in the right child
+			uint_t i;
+			if(!pos){
+				i = forward ? 0 : ke - kb;
+			} else if(forward || inclusive){
+				i = child_index(node, *pos);
+			} else {
+				i = std::lower_bound(kb, ke, *pos) - kb;
+			}
+			// Deeper separators are closer
+			if(forward && kb+i != ke){
+				bound = *(kb+i);
+				bounded = true;
+			} else if(!forward && i){
+				bound = *(kb+i-1);
+				bounded = true;
+			}
+			scan_leaf((*node->get_nodes())[i], pos, inclusive, forward, keys, vals, bound, bounded);
+		}
+	} catch(...){
+		d_leave(node, tree_t::PROCESS_TYPE::READ);
+		throw;
+	}
+	
+	d_leave(node, tree_t::PROCESS_TYPE::READ);
+}
+
+bool forest::details::Tree::collect_separators(tree_t::node_ptr node, tree_t::key_type& from, tree_t::key_type& to, int depth, std::vector<tree_t::key_type>& keys)
+{
+	// Returns true if there is one more internal level under the collected one
+	if(node->is_leaf()){
+		return false;
+	}
+	
+	d_enter(node, tree_t::PROCESS_TYPE::READ);
+	
+	bool deeper = false;
+	try{
+		auto* nodes = node->get_nodes();
+		auto kb = node->keys_iterator();
+		auto ke = node->keys_iterator_end();
+		
+		// Children intersecting with the range
+		uint_t first = child_index(node, from);
+		uint_t last = std::lower_bound(kb, ke, to) - kb;
+		
+		for(uint_t i=first;i<=last;i++){
+			if(depth){
+				deeper = collect_separators((*nodes)[i], from, to, depth-1, keys) || deeper;
+			} else if(!(*nodes)[i]->is_leaf()){
+				deeper = true;
+			}
+			if(i < last){
+				keys.push_back(*(kb+i));
+			}
+		}
+	} catch(...){
+		d_leave(node, tree_t::PROCESS_TYPE::READ);
+		throw;
+	}
+	
+	d_leave(node, tree_t::PROCESS_TYPE::READ);
+	
+	return deeper;
+}
+
+forest::details::uint_t forest::details::Tree::detach_range(tree_t::key_type& from, tree_t::key_type& to)
+{
+	// Children lying strictly inside of the range are cut off their parents
+	// without reading their records, so only the boundary leafs are left
+	// for the removal by keys. Snapshots need a preimage of every record.
+	{
+		std::shared_lock<std::shared_mutex> lock(snapshots_m);
+		if(snapshots.size()){
+			return 0;
+		}
+	}
+	
+	std::shared_lock<std::shared_mutex> lock(count_m);
+	tree->lock_write();
+	
+	tree_t::node_ptr root = tree->get_root_pub();
+	tree_t::node_ptr last;
+	bool gap = false;
+	std::vector<tree_t::node_ptr> detached;
+	int_t removed = 0;
+	
+	try{
+		if(has_data(root) && !root->is_leaf()){
+			removed = detach_range(root, from, to, nullptr, nullptr, last, gap, detached);
+		}
+		
+		// Files are removed once nothing refers to the nodes
+		for(auto& node : detached){
+			string path = get_node_data(node)->path;
+			savior->save(path, true);
+			if(node->is_leaf()){
+				bloom_drop(node.get());
+			}
+			cache::clear_node_cache(node);
+			savior->remove_file_async(path);
+		}
+	} catch(...){
+		tree->v_count -= removed;
+		tree->unlock_write();
+		throw;
+	}
+	
+	tree->v_count -= removed;
+	tree->unlock_write();
+	
+	return removed;
+}
+
+forest::details::int_t forest::details::Tree::detach_range(tree_t::node_ptr node, tree_t::key_type& from, tree_t::key_type& to, const tree_t::key_type* lo, const tree_t::key_type* hi, tree_t::node_ptr& last, bool& gap, std::vector<tree_t::node_ptr>& detached)
+{
+	d_enter(node, tree_t::PROCESS_TYPE::WRITE);
+	
+	int_t removed = 0;
+	try{
+		auto* nodes = node->get_nodes();
+		auto* keys = node->get_keys();
+		auto kb = node->keys_iterator();
+		auto ke = node->keys_iterator_end();
+		
+		// Children intersecting with the range
+		uint_t first = child_index(node, from);
+		uint_t end = std::lower_bound(kb, ke, to) - kb;
+		
+		uint_t left = nodes->size();
+		std::vector<uint_t> cut;
+		bool changed = false;
+		
+		for(uint_t i=first;i<=end;i++){
+			auto& child = (*nodes)[i];
+			const tree_t::key_type* c_lo = i ? &*(kb+i-1) : lo;
+			const tree_t::key_type* c_hi = kb+i != ke ? &*(kb+i) : hi;
+			
+			// Neighbours of a covered child intersect with the range too,
+			// so the leafs around a cut are always visited and kept.
+			// Node keeps two children at least.
+			bool covered = c_lo && c_hi && from < *c_lo && *c_hi < to;
+			int_t c = -1;
+			if(covered && left > 2){
+				uint_t size = detached.size();
+				c = detached_count(child, detached);
+				if(c < 0){
+					detached.resize(size);
+				}
+			}
+			
+			if(c >= 0){
+				cut.push_back(i);
+				left--;
+				removed += c;
+				gap = true;
+			} else if(!child->is_leaf()){
+				int_t r = detach_range(child, from, to, c_lo, c_hi, last, gap, detached);
+				if(r){
+					auto& count = node_data(child.get())->count;
+					int_t cc = count;
+					if(cc >= 0){
+						count = cc - r;
+					}
+					removed += r;
+					changed = true;
+				}
+			} else {
+				if(gap && last){
+					relink_leafs(last, child);
+				}
+				last = child;
+				gap = false;
+			}
+		}
+		
+		// Separator on the left goes with the child, the first child takes the right one
+		for(auto it = cut.rbegin(); it != cut.rend(); ++it){
+			nodes->erase(nodes->begin() + *it);
+			keys->erase(keys->begin() + (*it ? *it-1 : 0));
+		}
+		
+		if(cut.size() || changed){
+			d_insert(node);
+		}
+	} catch(...){
+		d_leave(node, tree_t::PROCESS_TYPE::WRITE);
+		throw;
+	}
+	
+	d_leave(node, tree_t::PROCESS_TYPE::WRITE);
+	
+	return removed;
+}
+
+forest::details::int_t forest::details::Tree::detached_count(tree_t::node_ptr& node, std::vector<tree_t::node_ptr>& detached)
+{
+	// Returns -1 if some leaf of the subtree is held by an iterator
+	if(!has_data(node)){
+		return -1;
+	}
+	
+	if(node->is_leaf()){
+		string& path = get_node_data(node)->path;
+		cache::leaf_lock();
+		/// lock{
+		auto it = cache::leaf_cache_r.find(path);
+		bool used = it != cache::leaf_cache_r.end() && it->second.second > 0;
+		/// }lock
+		cache::leaf_unlock();
+		if(used){
+			return -1;
+		}
+		detached.push_back(node);
+		int_t c = node_data(node.get())->count;
+		return c >= 0 ? c : leaf_size(path);
+	}
+	
+	d_enter(node, tree_t::PROCESS_TYPE::READ);
+	
+	int_t c = 0;
+	try{
+		for(auto& child : *node->get_nodes()){
+			int_t cc = detached_count(child, detached);
+			if(cc < 0){
+				c = -1;
+				break;
+			}
+			c += cc;
+		}
+	} catch(...){
+		d_leave(node, tree_t::PROCESS_TYPE::READ);
+		throw;
+	}
+	
+	d_leave(node, tree_t::PROCESS_TYPE::READ);
+	
+	if(c >= 0){
+		detached.push_back(node);
+	}
+	
+	return c;
+}
+
+forest::details::int_t forest::details::Tree::leaf_size(const string& path)
+{
+	// Record count is the first number of the leaf file
+	savior->get(path);
+	
+	DBFS::File* f = new DBFS::File(path);
+	string head;
+	try{
+		head = io::read_head(f, 1);
+	} catch(...){
+		delete f;
+		throw;
+	}
+	f->close();
+	delete f;
+	
+	std::string_view view = head;
+	int c;
+	if(!next_number(view, c) || c < 0){
+		L_ERR("[Tree::leaf_size]-(cannot read file)");
+		throw TreeException(TreeException::ERRORS::CANNOT_READ_FILE);
+	}
+	
+	return c;
+}
+
+void forest::details::Tree::relink_leafs(tree_t::node_ptr& left, tree_t::node_ptr& right)
+{
+	// Joins the leafs around the detached ones
+	d_enter(left, tree_t::PROCESS_TYPE::WRITE);
+	try{
+		d_enter(right, tree_t::PROCESS_TYPE::WRITE);
+	} catch(...){
+		d_leave(left, tree_t::PROCESS_TYPE::WRITE);
+		throw;
+	}
+	
+	try{
+		d_leaf_ref(left, right, tree_t::LEAF_REF::NEXT);
+		d_leaf_ref(right, left, tree_t::LEAF_REF::PREV);
+		d_insert(left);
+		d_insert(right);
+	} catch(...){
+		d_leave(right, tree_t::PROCESS_TYPE::WRITE);
+		d_leave(left, tree_t::PROCESS_TYPE::WRITE);
+		throw;
+	}
+	
+	d_leave(right, tree_t::PROCESS_TYPE::WRITE);
+	d_leave(left, tree_t::PROCESS_TYPE::WRITE);
+}
+
+void forest::details::Tree::visit_batch(const std::vector<tree_t::key_type>& keys, const std::function<void(uint_t, tree_t::val_type&)>& found)
+{
+	// Keys are expected to be sorted
+	if(keys.empty()){
+		return;
+	}
+	
+	tree->lock_read();
+	
+	tree_t::node_ptr root = tree->get_root_pub();
+	
+	// Root without data was never entered, so the tree is empty
+	if(!has_data(root) || bloom_skips(root, keys, 0, keys.size())){
+		tree->unlock_read();
+		return;
+	}
+	
+	try{
+		visit_batch(root, keys, 0, keys.size(), found);
+	} catch(...){
+		tree->unlock_read();
+		throw;
+	}
+	
+	tree->unlock_read();
+}
+
+void forest::details::Tree::visit_batch(tree_t::node_ptr node, const std::vector<tree_t::key_type>& keys, uint_t from, uint_t to, const std::function<void(uint_t, tree_t::val_type&)>& found)
+{
+	d_enter(node, tree_t::PROCESS_TYPE::READ);
+	
+	try{
+		if(node->is_leaf()){
+			// Merge sorted keys with the leaf items
+			auto* childs = node->get_childs();
+			auto it = childs->begin();
+			uint_t i = from;
+			while(it != childs->end() && i < to){
+				const tree_t::key_type& key = it->data->item->first;
+				if(key < keys[i]){
+					it = childs->find_next(it);
+				} else if(keys[i] < key){
+					i++;
+				} else {
+					found(i++, it->data->item->second);
+				}
+			}
+		} else {
+			// Split keys between children, equal keys belongs to the right child
+			auto* nodes = node->get_nodes();
+			auto kb = node->keys_iterator();
+			auto ke = node->keys_iterator_end();
+			uint_t i = from;
+			while(i < to){
+				auto sep = kb + child_index(node, keys[i]);
+				uint_t child = sep - kb;
+				uint_t j = i+1;
+				if(sep == ke){
+					j = to;
+				} else {
+					while(j < to && keys[j] < *sep){
+						j++;
+					}
+				}
+				if(!bloom_skips((*nodes)[child], keys, i, j)){
+					visit_batch((*nodes)[child], keys, i, j, found);
+				}
+				i = j;
+			}
+		}
+	} catch(...){
+		d_leave(node, tree_t::PROCESS_TYPE::READ);
+		throw;
+	}
+	
+	d_leave(node, tree_t::PROCESS_TYPE::READ);
+}
+
+void forest::details::Tree::insert_item(tree_t::key_type& key, tree_t::val_type val, bool update)
+{
+	std::shared_lock<std::shared_mutex> lock(count_m);
+	count_delta = 0;
+	count_restructured = false;
+	count_nodes.clear();
+	split_left = split_right = nullptr;
+	capture(key);
+	// Only new records pass the leaf insert hook, replaced values pass none
+	// or the delete hook of the old record, so the delta counts new keys only
+	count_tracking = true;
+	try{
+		tree->insert(make_pair(key, std::move(val)), update);
+	} catch(...){
+		count_tracking = false;
+		split_left = split_right = nullptr;
+		throw;
+	}
+	count_tracking = false;
+	// Split without a separator insert leaves stale nodes behind
+	split_left = split_right = nullptr;
+	update_counts(key);
+}
+
+void forest::details::Tree::erase_item(tree_t::key_type& key)
+{
+	std::shared_lock<std::shared_mutex> lock(count_m);
+	count_delta = 0;
+	count_restructured = false;
+	count_nodes.clear();
+	split_left = split_right = nullptr;
+	capture(key);
+	count_tracking = true;
+	try{
+		tree->erase(key);
+	} catch(...){
+		count_tracking = false;
+		split_left = split_right = nullptr;
+		throw;
+	}
+	count_tracking = false;
+	// Split without a separator insert leaves stale nodes behind
+	split_left = split_right = nullptr;
+	update_counts(key);
+}
+
+void forest::details::Tree::capture(tree_t::key_type& key)
+{
+	std::shared_lock<std::shared_mutex> lock(snapshots_m);
+	
+	bool needed = false;
+	for(auto* snap : snapshots){
+		if(!snap->captured(key)){
+			needed = true;
+		}
+	}
+	if(!needed){
+		return;
+	}
+	
+	// Value before the change, nullptr if the key does not exist yet
+	tree_t::val_type val;
+	{
+		auto it = tree->find(key);
+		if(it != tree->end()){
+			val = it->second->snapshot();
+		}
+	}
+	
+	for(auto* snap : snapshots){
+		snap->capture(key, val);
+	}
+}
+
+void forest::details::Tree::update_counts(tree_t::key_type& key)
+{
+	int_t delta = count_delta;
+	bool restructured = count_restructured;
+	count_delta = 0;
+	count_restructured = false;
+	
+	// Nothing to update until some counts are known
+	if(!counted || (!delta && !restructured)){
+		return;
+	}
+	
+	tree->lock_read();
+	
+	tree_t::node_ptr root = tree->get_root_pub();
+	
+	try{
+		// Count of the root is the tree size
+		if(has_data(root) && !root->is_leaf()){
+			update_counts(root, key, delta, restructured);
+		}
+	} catch(...){
+		tree->unlock_read();
+		throw;
+	}
+	
+	tree->unlock_read();
+}
+
+void forest::details::Tree::update_counts(tree_t::node_ptr node, tree_t::key_type& key, int_t delta, bool restructured)
+{
+	d_enter(node, tree_t::PROCESS_TYPE::READ);
+	
+	try{
+		auto* nodes = node->get_nodes();
+		uint_t i = child_index(node, key);
+		bool changed = false;
+		
+		// Deeper counts first, changed nodes are summed from their children
+		if(!(*nodes)[i]->is_leaf()){
+			update_counts((*nodes)[i], key, delta, restructured);
+		}
+		
+		for(uint_t j=0;j<nodes->size();j++){
+			auto& child = (*nodes)[j];
+			if(!has_data(child)){
+				continue;
+			}
+			auto& count = node_data(child.get())->count;
+			if(restructured && count_changed(child.get())){
+				// Children of the path are already updated
+				int_t c = changed_count(child, j != i);
+				if(count.exchange(c) != c){
+					changed = true;
+				}
+			} else if(j == i){
+				// Unknown count stays unknown
+				int_t c = count;
+				while(c >= 0 && !count.compare_exchange_weak(c, c + delta));
+				if(c >= 0){
+					changed = true;
+				}
+			}
+		}
+		
+		// Counts are stored in the node file
+		if(changed){
+			d_insert(node);
+		}
+	} catch(...){
+		d_leave(node, tree_t::PROCESS_TYPE::READ);
+		throw;
+	}
+	
+	d_leave(node, tree_t::PROCESS_TYPE::READ);
+}
+
+bool forest::details::Tree::count_changed(tree_t::Node* node)
+{
+	return std::find(count_nodes.begin(), count_nodes.end(), node) != count_nodes.end();
+}
+
+forest::details::int_t forest::details::Tree::changed_count(tree_t::node_ptr node, bool deep)
+{
+	d_enter(node, tree_t::PROCESS_TYPE::READ);
 	
-	// Init BPT
-	t->set_tree(new tree_t(base.factor, create_node(base.branch, base.branch_type), base.count, t.get()));
+	int_t c = 0;
+	try{
+		if(node->is_leaf()){
+			auto* childs = node->get_childs();
+			for(auto it = childs->begin(); it != childs->end(); it = childs->find_next(it)){
+				c++;
+			}
+		} else {
+			// Children moved from other nodes keep their own counts
+			for(auto& child : *node->get_nodes()){
+				if(!has_data(child)){
+					c = -1;
+					break;
+				}
+				auto& count = node_data(child.get())->count;
+				if(deep && count_changed(child.get())){
+					count = changed_count(child, true);
+				}
+				int_t cc = count;
+				if(cc < 0){
+					c = -1;
+					break;
+				}
+				c += cc;
+			}
+		}
+	} catch(...){
+		d_leave(node, tree_t::PROCESS_TYPE::READ);
+		throw;
+	}
 	
-	cache::tree_cache_m.lock();
+	d_leave(node, tree_t::PROCESS_TYPE::READ);
 	
-	cache::tree_cache.push(path, t);
-	cache::tree_cache_r[path].second--;
-	t->unlock();
-
-	// return value
-	return t;
+	return c;
 }
 
-forest::details::tree_t* forest::details::Tree::get_tree()
+forest::details::int_t forest::details::Tree::count_search(std::function<int_t(tree_t::node_ptr&, bool)> search)
 {
-	return this->tree;
+	int_t res;
+	
+	// Try known counts first, writers are not blocked
+	{
+		std::shared_lock<std::shared_mutex> lock(count_m);
+		tree->lock_read();
+		tree_t::node_ptr root = tree->get_root_pub();
+		try{
+			res = has_data(root) ? search(root, false) : 0;
+		} catch(...){
+			tree->unlock_read();
+			throw;
+		}
+		tree->unlock_read();
+		if(res >= 0){
+			return res;
+		}
+	}
+	
+	// Recount missing counts without writers in progress
+	std::unique_lock<std::shared_mutex> lock(count_m);
+	tree->lock_read();
+	tree_t::node_ptr root = tree->get_root_pub();
+	try{
+		res = has_data(root) ? search(root, true) : 0;
+	} catch(...){
+		tree->unlock_read();
+		throw;
+	}
+	tree->unlock_read();
+	
+	return res;
 }
 
-void forest::details::Tree::set_tree(tree_t* tree)
+forest::details::int_t forest::details::Tree::child_count(tree_t::node_ptr& node, tree_t::node_ptr& child, bool recount)
 {
-	this->tree = tree;
+	// Expects node to be entered
+	if(has_data(child)){
+		int_t c = node_data(child.get())->count;
+		if(c >= 0){
+			return c;
+		}
+	}
+	
+	if(!recount){
+		return -1;
+	}
+	
+	int_t c = subtree_count(child);
+	node_data(child.get())->count = c;
+	counted = true;
+	d_insert(node);
+	
+	return c;
 }
 
-void forest::details::Tree::insert(tree_t::key_type key, tree_t::val_type val, bool update)
+forest::details::int_t forest::details::Tree::subtree_count(tree_t::node_ptr node)
 {
-	tree->insert(make_pair(key, std::move(val)), update);
-	tree->save_base();
+	d_enter(node, tree_t::PROCESS_TYPE::READ);
+	
+	int_t c = 0;
+	try{
+		if(node->is_leaf()){
+			auto* childs = node->get_childs();
+			for(auto it = childs->begin(); it != childs->end(); it = childs->find_next(it)){
+				c++;
+			}
+		} else {
+			for(auto& child : *node->get_nodes()){
+				c += child_count(node, child, true);
+			}
+		}
+	} catch(...){
+		d_leave(node, tree_t::PROCESS_TYPE::READ);
+		throw;
+	}
+	
+	d_leave(node, tree_t::PROCESS_TYPE::READ);
+	
+	return c;
 }
 
-void forest::details::Tree::erase(tree_t::key_type key)
+forest::details::int_t forest::details::Tree::count_less(tree_t::node_ptr node, tree_t::key_type& key, bool recount)
 {
-	tree->erase(key);
-	tree->save_base();
+	d_enter(node, tree_t::PROCESS_TYPE::READ);
+	
+	int_t c = 0;
+	try{
+		if(node->is_leaf()){
+			auto* childs = node->get_childs();
+			for(auto it = childs->begin(); it != childs->end() && it->data->item->first < key; it = childs->find_next(it)){
+				c++;
+			}
+		} else {
+			// Children before the one containing the key are counted as a whole
+			auto* nodes = node->get_nodes();
+			uint_t i = child_index(node, key);
+			for(uint_t j=0;j<i && c>=0;j++){
+				int_t cc = child_count(node, (*nodes)[j], recount);
+				c = (cc < 0) ? -1 : c + cc;
+			}
+			if(c >= 0){
+				int_t cc = count_less((*nodes)[i], key, recount);
+				c = (cc < 0) ? -1 : c + cc;
+			}
+		}
+	} catch(...){
+		d_leave(node, tree_t::PROCESS_TYPE::READ);
+		throw;
+	}
+	
+	d_leave(node, tree_t::PROCESS_TYPE::READ);
+	
+	return c;
 }
 
-forest::details::tree_t::iterator forest::details::Tree::find(tree_t::key_type key)
+forest::details::int_t forest::details::Tree::key_at(tree_t::node_ptr node, uint_t index, tree_t::key_type& key, bool recount)
 {
-	auto it = tree->find(key);
-	if(it == tree->end()){
-		throw TreeException(TreeException::ERRORS::LEAF_DOES_NOT_EXISTS);
+	d_enter(node, tree_t::PROCESS_TYPE::READ);
+	
+	// -1 if some count is unknown, 0 if not found, 1 if found
+	int_t res = 0;
+	try{
+		if(node->is_leaf()){
+			auto* childs = node->get_childs();
+			for(auto it = childs->begin(); it != childs->end(); it = childs->find_next(it)){
+				if(!index--){
+					key = it->data->item->first;
+					res = 1;
+					break;
+				}
+			}
+		} else {
+			for(auto& child : *node->get_nodes()){
+				int_t c = child_count(node, child, recount);
+				if(c < 0){
+					res = -1;
+					break;
+				}
+				if(index < (uint_t)c){
+					res = key_at(child, index, key, recount);
+					break;
+				}
+				index -= c;
+			}
+		}
+	} catch(...){
+		d_leave(node, tree_t::PROCESS_TYPE::READ);
+		throw;
 	}
-	return it;
+	
+	d_leave(node, tree_t::PROCESS_TYPE::READ);
+	
+	return res;
 }
 
-
-///////////////////////////////////////////////////////////////////////////
-
-
 void forest::details::Tree::seed_tree(DBFS::File* f, TREE_TYPES type, int factor)
 {
 	if(f->fail()){
@@ -142,7 +1611,7 @@ void forest::details::Tree::seed_tree(DBFS::File* f, TREE_TYPES type, int factor
 	}
 	
 	tree_base_read_t base_d;
-	base_d.type = TREE_TYPES::KEY_STRING;
+	base_d.type = type;
 	base_d.branch_type = NODE_TYPES::LEAF;
 	base_d.count = 0;
 	base_d.factor = factor;
@@ -217,6 +1686,16 @@ forest::details::tree_base_read_t forest::details::Tree::read_base(string filena
 		delete f;
 		throw TreeException(TreeException::ERRORS::CANNOT_READ_FILE);
 	}
+	
+	// Options, missing in the files of older versions
+	f->read(ret.bloom_bits);
+	if(f->fail()){
+		ret.bloom_bits = 0;
+	}
+	f->read(ret.hash_index);
+	if(f->fail()){
+		ret.hash_index = 0;
+	}
 
 	f->close();
 	delete f;
@@ -224,6 +1703,13 @@ forest::details::tree_base_read_t forest::details::Tree::read_base(string filena
 	return ret;
 }
 
+void forest::details::Tree::set_options(const tree_base_read_t& base)
+{
+	factor = base.factor;
+	bloom_bits = base.bloom_bits;
+	hash_index = base.hash_index;
+}
+
 forest::details::tree_intr_read_t forest::details::Tree::read_intr(string filename)
 {	
 	// Wait for file to become ready
@@ -234,35 +1720,72 @@ forest::details::tree_intr_read_t forest::details::Tree::read_intr(string filena
 	
 	DBFS::File* f = new DBFS::File(filename);
 	
-	f->seekg(0);
-	f->read(t);
-	f->read(c);
+	// Read the whole node at once
+	std::istringstream ss;
+	try{
+		ss.str(io::read_head(f, 4));
+	} catch(...){
+		delete f;
+		throw;
+	}
+	f->close();
+	delete f;
+	
+	ss >> t;
+	ss >> c;
+	
+	// Key format follows on the first line, files of older versions have none
+	int format = KEYS_PLAIN;
+	string rest;
+	std::getline(ss, rest);
+	std::istringstream(rest) >> format;
+	if(format != KEYS_PLAIN && format != KEYS_FRONT_CODED){
+		ss.setstate(std::ios::failbit);
+	}
 	
 	std::vector<key_type>* keys = new std::vector<key_type>(c-1);
 	std::vector<string>* vals = new std::vector<string>(c);
 	
-	for(int i=0;i<c-1;i++){
-		f->read((*keys)[i]);
+	if(format == KEYS_FRONT_CODED){
+		string token;
+		key_type key;
+		for(int i=0;i<c-1;i++){
+			if(!(ss >> token) || !front_decode(token, key)){
+				ss.setstate(std::ios::failbit);
+				break;
+			}
+			(*keys)[i] = key;
+		}
+	} else {
+		for(int i=0;i<c-1;i++){
+			ss >> (*keys)[i];
+		}
 	}
 	for(int i=0;i<c;i++){
-		f->read((*vals)[i]);
+		ss >> (*vals)[i];
 	}
 	
-	if(f->fail()){
+	if(ss.fail()){
 		L_ERR("[Tree::read_intr]-(cannot read file)");
 		delete keys;
 		delete vals;
-		delete f;
 		throw TreeException(TreeException::ERRORS::CANNOT_READ_FILE);
 	}
 	
-	f->close();
-	delete f;
+	// Subtree counts are optional, files written before them have none
+	std::vector<int_t>* counts = new std::vector<int_t>(c, -1);
+	for(int i=0;i<c;i++){
+		if(!(ss >> (*counts)[i])){
+			counts->assign(c, -1);
+			break;
+		}
+	}
 	
 	tree_intr_read_t d;
 	d.childs_type = (NODE_TYPES)t;
 	d.child_keys = keys;
 	d.child_values = vals;
+	d.child_counts = counts;
 	
 	return d;
 }
@@ -277,26 +1800,67 @@ forest::details::tree_leaf_read_t forest::details::Tree::read_leaf(string filena
 	int c;
 	string left_leaf, right_leaf;
 	uint_t start_data;
+	const char* map_data = nullptr;
+	uint_t map_size = 0;
 	
-	f->seekg(0);
-	f->read(c);
-	f->read(left_leaf);
-	f->read(right_leaf);
+	if(MMAP_LEAFS){
+		map_data = io::map(f, map_size);
+	}
 	
-	auto* keys = new std::vector<tree_t::key_type>(c);
-	auto* vals_lengths = new std::vector<uint_t>(c);
-	for(int i=0;i<c;i++){
-		f->read((*keys)[i]);
+	// Read the header at once, data starts right after it.
+	// Tokens are taken straight from it, without a stream.
+	string head_buf;
+	std::string_view head;
+	try{
+		if(map_data){
+			head = std::string_view(map_data, io::head_length(map_data, map_size, 3));
+		} else {
+			head_buf = io::read_head(f, 3);
+			head = head_buf;
+		}
+	} catch(...){
+		io::unmap(map_data, map_size);
+		delete f;
+		throw;
 	}
-	for(int i=0;i<c;i++){
-		f->read((*vals_lengths)[i]);
+	start_data = head.size();
+	
+	std::string_view token;
+	bool ok = next_number(head, c) && c >= 0;
+	ok = ok && next_token(head, token);
+	left_leaf = string(token);
+	ok = ok && next_token(head, token);
+	right_leaf = string(token);
+	
+	// Key format follows on the first line, files of older versions have none
+	int format = KEYS_PLAIN;
+	if(ok && next_line_token(head, token)){
+		auto res = std::from_chars(token.data(), token.data() + token.size(), format);
+		ok = res.ec == std::errc() && (format == KEYS_PLAIN || format == KEYS_FRONT_CODED);
 	}
-	start_data = f->tellg()+1;
 	
-	if(f->fail()){
+	auto* keys = new std::vector<tree_t::key_type>();
+	auto* vals_lengths = new std::vector<uint_t>(ok ? c : 0);
+	keys->reserve(ok ? c : 0);
+	tree_t::key_type key;
+	for(int i=0;ok && i<c;i++){
+		ok = next_token(head, token);
+		if(format == KEYS_FRONT_CODED){
+			ok = ok && front_decode(token, key);
+			keys->push_back(key);
+		} else {
+			keys->emplace_back(token);
+		}
+	}
+	for(int i=0;ok && i<c;i++){
+		ok = next_number(head, (*vals_lengths)[i]);
+	}
+	
+	if(!ok){
 		L_ERR("[Tree::read_leaf]-(cannot read file)");
 		delete keys;
 		delete vals_lengths;
+		io::unmap(map_data, map_size);
 		delete f;
 		throw TreeException(TreeException::ERRORS::CANNOT_READ_FILE);
 	}
@@ -308,11 +1872,13 @@ forest::details::tree_leaf_read_t forest::details::Tree::read_leaf(string filena
 	t.right_leaf = right_leaf;
 	t.start_data = start_data;
 	t.file = f;
+	t.map_data = map_data;
+	t.map_size = map_size;
 	
 	return t;
 }
 
-void forest::details::Tree::materialize_intr(tree_t::node_ptr node)
+void forest::details::Tree::materialize_intr(tree_t::node_ptr& node)
 {
 	tree_t::node_ptr n;
 	node_data_ptr data;
@@ -362,13 +1928,14 @@ void forest::details::Tree::materialize_intr(tree_t::node_ptr node)
 	if(!own_inc(node)){
 		node->set_keys(n->get_keys());
 		node->set_nodes(n->get_nodes());
+		share_key_index(node.get(), n.get());
 		data->ghost = false;
 	}
 	/// }own_lock
 	own_unlock(node);
 }
 
-void forest::details::Tree::materialize_leaf(tree_t::node_ptr node)
+void forest::details::Tree::materialize_leaf(tree_t::node_ptr& node)
 {
 	tree_t::node_ptr n, next_leaf, prev_leaf;
 	node_data_ptr data;
@@ -437,7 +2004,7 @@ void forest::details::Tree::materialize_leaf(tree_t::node_ptr node)
 	own_unlock(node);
 }
 
-void forest::details::Tree::unmaterialize_intr(tree_t::node_ptr node)
+void forest::details::Tree::unmaterialize_intr(tree_t::node_ptr& node)
 {
 	// Get node data
 	node_data_ptr data = get_node_data(node);
@@ -468,7 +2035,7 @@ void forest::details::Tree::unmaterialize_intr(tree_t::node_ptr node)
 	cache::release_node(n, true);
 }
 
-void forest::details::Tree::unmaterialize_leaf(tree_t::node_ptr node)
+void forest::details::Tree::unmaterialize_leaf(tree_t::node_ptr& node)
 {
 	// Unlock original node if it was not already deleted
 	cache::leaf_lock();
@@ -561,6 +2128,42 @@ void forest::details::Tree::set_annotation(string annotation)
 	this->annotation = annotation;
 }
 
+int forest::details::Tree::get_bloom_bits()
+{
+	return bloom_bits;
+}
+
+forest::details::uint_t forest::details::Tree::get_skipped_leafs()
+{
+	return skipped_leafs;
+}
+
+void forest::details::Tree::set_bloom_bits(int bits)
+{
+	// Filters built with other parameters are dropped
+	{
+		std::lock_guard<std::mutex> lock(blooms_m);
+		bloom_bits = bits;
+		leaf_blooms.clear();
+	}
+	tree->save_base();
+}
+
+bool forest::details::Tree::get_hash_index()
+{
+	return hash_index;
+}
+
+void forest::details::Tree::set_hash_index(bool enabled)
+{
+	hash_index = enabled;
+	for(auto& shard : leaf_hash){
+		std::unique_lock<std::shared_mutex> lock(shard.m);
+		shard.map.clear();
+	}
+	tree->save_base();
+}
+
 forest::TREE_TYPES forest::details::Tree::get_type()
 {
 	return type;
@@ -601,6 +2204,7 @@ forest::details::tree_t::node_ptr forest::details::Tree::get_intr(string path)
 	tree_intr_read_t intr_d = read_intr(path);
 	std::vector<tree_t::key_type>* keys_ptr = intr_d.child_keys;
 	std::vector<string>* vals_ptr = intr_d.child_values;
+	std::vector<int_t>* counts_ptr = intr_d.child_counts;
 	intr_data->add_keys(0, keys_ptr->begin(), keys_ptr->end());
 	int c = vals_ptr->size();
 	for(int i=0;i<c;i++){
@@ -612,13 +2216,19 @@ forest::details::tree_t::node_ptr forest::details::Tree::get_intr(string path)
 			n = node_ptr(new typename tree_t::LeafNode(nullptr));
 		}
 		set_node_data(n, create_node_data(true, child_path));
+		if((*counts_ptr)[i] >= 0){
+			node_data(n.get())->count = (*counts_ptr)[i];
+			counted = true;
+		}
 		intr_data->add_nodes(i,n);
 	}
 	set_node_data(intr_data, create_node_data(false, path));
+	build_key_index(intr_data.get(), type != TREE_TYPES::KEY_STRING);
 	
 	// Clear memory
 	delete keys_ptr;
 	delete vals_ptr;
+	delete counts_ptr;
 	
 	// Unlock node
 	cache::intr_lock();
@@ -664,13 +2274,23 @@ forest::details::tree_t::node_ptr forest::details::Tree::get_leaf(string path)
 	std::vector<tree_t::key_type>* keys_ptr = leaf_d.child_keys;
 	std::vector<uint_t>* vals_length = leaf_d.child_lengths;
 	uint_t start_data = leaf_d.start_data;
-	file_ptr f(leaf_d.file);
+	vfile_ptr f(new vfile(path, leaf_d.file));
+	if(leaf_d.map_data){
+		f->set_mapping(leaf_d.map_data, leaf_d.map_size);
+	}
 	get_data(leaf_data).f = f;
 	int c = keys_ptr->size();
 	uint_t last_len = 0;
 	
+	if(bloom_bits){
+		bloom_build(path, *keys_ptr);
+	}
+	
+	// Value descriptors share one allocation
+	block_allocator<file_data_t> alloc(std::make_shared<file_data_block>(c));
 	for(int i=0;i<c;i++){
-		leaf_data->insert(this->tree->create_entry_item( (*keys_ptr)[i], file_data_ptr(new file_data_t(f, start_data+last_len, (*vals_length)[i])) ));
+		file_data_ptr item = std::allocate_shared<file_data_t>(alloc, f, start_data+last_len, (*vals_length)[i]);
+		leaf_data->insert(this->tree->create_entry_item( std::move((*keys_ptr)[i]), item ));
 		last_len += (*vals_length)[i];
 	}
 	
@@ -704,7 +2324,7 @@ forest::details::tree_t::node_ptr forest::details::Tree::get_leaf(string path)
 	return leaf_data;
 }
 
-forest::details::tree_t::node_ptr forest::details::Tree::get_original(tree_t::node_ptr node)
+forest::details::tree_t::node_ptr forest::details::Tree::get_original(const tree_t::node_ptr& node)
 {
 	node_ptr n;
 	
@@ -753,13 +2373,66 @@ forest::details::tree_t::node_ptr forest::details::Tree::get_original(tree_t::no
 	return n;
 }
 
-forest::details::tree_t::node_ptr forest::details::Tree::extract_node(tree_t::child_item_type_ptr item)
+forest::details::tree_t::Node* forest::details::Tree::get_original_raw(tree_t::Node* node)
+{
+	// Same as get_original, but without reference counting.
+	// Must be called under the cache lock and inside of an epoch guard.
+	if(get_data(node).is_original){
+		return node;
+	}
+	
+	string& path = node_data(node)->path;
+	
+	if(node->is_leaf()){
+		auto it = cache::leaf_cache_r.find(path);
+		if(it != cache::leaf_cache_r.end()){
+			if(cache::leaf_cache.has(path)){
+				cache::leaf_cache.get(path);
+			} else {
+				cache::leaf_cache.push(path, it->second.first);
+			}
+			return it->second.first.get();
+		}
+	} else {
+		auto it = cache::intr_cache_r.find(path);
+		if(it != cache::intr_cache_r.end()){
+			if(cache::intr_cache.has(path)){
+				cache::intr_cache.get(path);
+			} else {
+				cache::intr_cache.push(path, it->second.first);
+			}
+			return it->second.first.get();
+		}
+	}
+	
+	// General way, the node is returned linked to the cache,
+	// and it is retired when it is unlinked from there
+	node_ptr n;
+	bool linked;
+	if(node->is_leaf()){
+		n = get_leaf(path);
+		auto it = cache::leaf_cache_r.find(path);
+		linked = it != cache::leaf_cache_r.end() && it->second.first == n;
+	} else {
+		n = get_intr(path);
+		auto it = cache::intr_cache_r.find(path);
+		linked = it != cache::intr_cache_r.end() && it->second.first == n;
+	}
+	
+	// Keep the node alive until the guard is left
+	if(!linked){
+		epoch::retire(n);
+	}
+	return n.get();
+}
+
+forest::details::tree_t::node_ptr forest::details::Tree::extract_node(const tree_t::child_item_type_ptr& item)
 {
 	std::lock_guard<std::mutex> lock(item->item->second->o);
 	return item->node.lock();
 }
 
-forest::details::tree_t::node_ptr forest::details::Tree::extract_locked_node(tree_t::child_item_type_ptr item, bool w_prior)
+forest::details::tree_t::node_ptr forest::details::Tree::extract_locked_node(const tree_t::child_item_type_ptr& item, bool w_prior)
 {	
 	tree_t::node_ptr node;
 	// Make sure to lock the right node
@@ -802,19 +2475,22 @@ void forest::details::Tree::save_intr(node_ptr node, DBFS::File* f)
 	int c = node->get_nodes()->size();
 	auto* keys = new std::vector<tree_t::key_type>(node->keys_iterator(), node->keys_iterator_end());
 	auto* nodes = new std::vector<string>(c);
+	auto* counts = new std::vector<int_t>(c);
 	
 	for(int i=0;i<c;i++){
 		node_data_ptr d = get_node_data( (*(node->get_nodes()))[i] );
 		(*nodes)[i] = d->path;
+		(*counts)[i] = d->count;
 	}
 	intr_d.child_keys = keys;
 	intr_d.child_values = nodes;
+	intr_d.child_counts = counts;
 	write_intr(f, intr_d);
 	
 	f->close();
 }
 
-void forest::details::Tree::save_leaf(node_ptr node, file_ptr fp)
+void forest::details::Tree::save_leaf(node_ptr node, vfile_ptr fp)
 {	
 	tree_leaf_read_t leaf_d;
 	auto* keys = new std::vector<tree_t::key_type>();
@@ -837,17 +2513,16 @@ void forest::details::Tree::save_leaf(node_ptr node, file_ptr fp)
 	
 	leaf_d.child_keys = keys;
 	leaf_d.child_lengths = lengths;
-	write_leaf(fp, leaf_d);
-	
-	auto lock = fp->get_lock();
+	auto h = fp->open();
+	uint_t start_data = write_leaf(h.file, leaf_d, h.fd);
 	
+	std::vector<tree_t::val_type*> items;
 	start = childs->begin();
 	while(start != childs->end()){
-		write_leaf_item(fp, start->data->item->second);
+		items.push_back(&start->data->item->second);
 		start = childs->find_next(start);
 	}
-	
-	fp->stream().flush();
+	write_leaf_items(fp, h.file, items, start_data, h.fd);
 }
 
 void forest::details::Tree::save_base(tree_ptr tree, DBFS::File* base_f)
@@ -856,7 +2531,7 @@ void forest::details::Tree::save_base(tree_ptr tree, DBFS::File* base_f)
 	base_d.type = tree->get_type();
 	
 	base_d.count = tree->get_tree()->size();
-	base_d.factor = tree->get_tree()->get_factor();
+	base_d.factor = tree->factor;
 	
 	tree_t::node_ptr root_node = tree->get_tree()->get_root_pub();
 	
@@ -869,6 +2544,8 @@ void forest::details::Tree::save_base(tree_ptr tree, DBFS::File* base_f)
 	}
 	
 	base_d.annotation = tree->annotation;
+	base_d.bloom_bits = tree->bloom_bits;
+	base_d.hash_index = tree->hash_index;
 	
 	write_base(base_f, base_d);
 	base_f->close();
@@ -879,94 +2556,142 @@ void forest::details::Tree::write_intr(DBFS::File* file, tree_intr_read_t data)
 {
 	auto* keys = data.child_keys;
 	auto* paths = data.child_values;
-	file->write( to_string((int)data.childs_type) + " " + to_string(paths->size()) + "\n" );
+	auto* counts = data.child_counts;
+	
+	int format = COMPRESS_KEYS ? KEYS_FRONT_CODED : KEYS_PLAIN;
 	
-	string valsStr = "";
 	std::stringstream ss;
-	for(auto& key : (*keys)){
-		ss << key << " ";
+	ss << to_string((int)data.childs_type) << " " << to_string(paths->size());
+	if(format != KEYS_PLAIN){
+		ss << " " << format;
 	}
+	ss << "\n";
+	write_keys(ss, *keys, format);
+	ss << "\n";
 	for(auto& val : (*paths)){
-		valsStr.append(val + " ");
+		ss << val << " ";
+	}
+	ss << "\n";
+	for(auto& count : (*counts)){
+		ss << count << " ";
 	}
-	file->write(ss.str() + "\n");
-	file->write(valsStr);
 	
 	// Clear memory
 	delete keys;
 	delete paths;
+	delete counts;
 	
-	if(file->fail()){
-		L_ERR("[Tree::write_intr]-(cannot write file)");
-		throw TreeException(TreeException::ERRORS::CANNOT_WRITE_FILE);
-	}
+	// Write the whole node at once
+	string str = ss.str();
+	io::write(file, str.c_str(), 0, str.size());
 }
 
 void forest::details::Tree::write_base(DBFS::File* file, tree_base_read_t data)
 {
-	file->write( to_string(data.count) + " " + to_string(data.factor) + " " + to_string((int)data.type) + " " + data.branch + " " + to_string((int)data.branch_type) + " " + to_string(data.annotation.size()) + " " + data.annotation + "\n" );
-	if(file->fail()){
-		L_ERR("[Tree::write_base]-(cannot write file)");
-		throw TreeException(TreeException::ERRORS::CANNOT_WRITE_FILE);
-	}
+	string str = to_string(data.count) + " " + to_string(data.factor) + " " + to_string((int)data.type) + " " + data.branch + " " + to_string((int)data.branch_type) + " " + to_string(data.annotation.size()) + " " + data.annotation + " " + to_string(data.bloom_bits) + " " + to_string(data.hash_index) + "\n";
+	io::write(file, str.c_str(), 0, str.size());
 }
 
-void forest::details::Tree::write_leaf(file_ptr file, tree_leaf_read_t data)
+forest::details::uint_t forest::details::Tree::write_leaf(DBFS::File* file, tree_leaf_read_t data, int fd)
 {
 	auto* keys = data.child_keys;
 	auto* lengths = data.child_lengths;
 	int c = keys->size();
-	file->write(to_string(c) + " " + data.left_leaf + " " + data.right_leaf+ "\n");
-	string lenStr = "";
+	
+	int format = COMPRESS_KEYS ? KEYS_FRONT_CODED : KEYS_PLAIN;
+	
 	std::stringstream ss;
-	for(auto& key : (*keys)){
-		ss << key << " ";
+	ss << to_string(c) << " " << data.left_leaf << " " << data.right_leaf;
+	if(format != KEYS_PLAIN){
+		ss << " " << format;
 	}
-	for(auto& len : (*lengths)){
-		lenStr.append(to_string(len) + " ");
-	}
-	if(lenStr.size()){
-		lenStr.pop_back();
+	ss << "\n";
+	write_keys(ss, *keys, format);
+	ss << "\n";
+	for(int i=0;i<c;i++){
+		if(i){
+			ss << " ";
+		}
+		ss << to_string((*lengths)[i]);
 	}
-	file->write(ss.str()+"\n");
-	file->write(lenStr+"\n");
+	ss << "\n";
 	
 	// Clear memory
 	delete keys;
 	delete lengths;
 	
-	if(file->fail()){
-		L_ERR("[Tree::write_leaf]-(cannot write file)");
-		throw TreeException(TreeException::ERRORS::CANNOT_WRITE_FILE);
-	}
+	string str = ss.str();
+	io::write(file, str.c_str(), 0, str.size(), fd);
+	
+	return str.size();
 }
 
-void forest::details::Tree::write_leaf_item(file_ptr file, tree_t::val_type& data)
+void forest::details::Tree::write_leaf_items(vfile_ptr vf, DBFS::File* file, std::vector<tree_t::val_type*>& items, uint_t pos, int fd)
 {
-	int_t start_data = file->tellp();
-	
-	int read_size = CHUNK_SIZE;
-	char* buf = new char[read_size];
-	int rsz;
-	auto reader = data->get_reader();
-	
-	try{
-		while( (rsz = reader.read(buf, read_size)) ){
-			file->write(buf, rsz);
+	using reader_ptr = std::unique_ptr<file_data_t::file_data_reader>;
+	
+	// Values are written one after another, so they are gathered into
+	// a buffer. Each value is read by chunks, a large one never takes
+	// more memory than the buffers. One buffer is filled while the other
+	// one is written.
+	std::unique_ptr<char[]> bufs[2] = {std::unique_ptr<char[]>(new char[io::BATCH_BYTES]), std::unique_ptr<char[]>(new char[io::BATCH_BYTES])};
+	int cur = 0;
+	uint_t filled = 0;
+	uint_t chunk = std::max(CHUNK_SIZE, 1);
+	io::batch b;
+	
+	// Readers keep values locked until they are moved to the new file
+	std::vector<std::pair<reader_ptr, uint_t> > moved, writing;
+	
+	auto relocate = [&vf](std::vector<std::pair<reader_ptr, uint_t> >& readers){
+		for(auto& m : readers){
+			m.first->relocate(vf, m.second);
 		}
-	} catch(...){
-		L_ERR("[Tree::write_leaf_item]-(cannot write file)");
-		throw TreeException(TreeException::ERRORS::CANNOT_WRITE_FILE);
+		readers.clear();
+	};
+	
+	auto flush = [&](){
+		// Previous buffer must be written before values are moved
+		b.wait();
+		relocate(writing);
+		if(filled){
+			b.write(file, bufs[cur].get(), pos, filled, fd);
+			b.submit();
+			pos += filled;
+			filled = 0;
+			cur ^= 1;
+		}
+		writing.swap(moved);
+	};
+	
+	for(auto* item : items){
+		reader_ptr reader(new file_data_t::file_data_reader(item->get()));
+		uint_t start = pos + filled;
+		while(true){
+			if(filled == io::BATCH_BYTES){
+				flush();
+			}
+			uint_t rsz = reader->read(bufs[cur].get() + filled, std::min<uint_t>(chunk, io::BATCH_BYTES - filled));
+			if(!rsz){
+				break;
+			}
+			filled += rsz;
+		}
+		moved.emplace_back(std::move(reader), start);
 	}
-	
-	delete[] buf;
-	data->set_start(start_data);
-	data->set_file(file);
+	flush();
+	b.wait();
+	relocate(writing);
 }
 
 // Proceed
 void forest::details::Tree::d_enter(tree_t::node_ptr& node, tree_t::PROCESS_TYPE type)
 {	
+	// Searched key is checked by the leaf filter before the leaf is read
+	if(bloom_key && node->is_leaf() && !tree->is_stem_pub(node) && bloom_skip(node)){
+		return;
+	}
+	
 	// Lock node mutex
 	lock_type(node, type);
 	
@@ -979,11 +2704,24 @@ void forest::details::Tree::d_enter(tree_t::node_ptr& node, tree_t::PROCESS_TYPE
 		materialize_intr(node);
 	} else {
 		materialize_leaf(node);
+		if(hash_index){
+			hash_leaf = get_node_data(node)->path;
+		}
 	}
 }
 
 void forest::details::Tree::d_leave(tree_t::node_ptr& node, tree_t::PROCESS_TYPE type)
 {	
+	// Leaf skipped by its filter was never materialized
+	if(node.get() == bloom_skipped){
+		own_lock(node);
+		node->set_childs(nullptr);
+		own_unlock(node);
+		bloom_skipped = nullptr;
+		unlock_write(node);
+		return;
+	}
+	
 	// Nothing to do with stem
 	if(tree->is_stem_pub(node)){
 		unlock_type(node, type);
@@ -1001,11 +2739,27 @@ void forest::details::Tree::d_leave(tree_t::node_ptr& node, tree_t::PROCESS_TYPE
 void forest::details::Tree::d_insert(tree_t::node_ptr& node)
 {	
 	if(!node->is_leaf()){
+		// Children of the node are changed
+		if(count_tracking){
+			count_nodes.push_back(node.get());
+			count_restructured = true;
+		}
+		
+		if(split_left){
+			truncate_separator(node);
+		}
+		
+		// Keys of the node are changed
+		reset_key_index(node.get());
 		
 		cache::intr_lock();
 		node_ptr n = get_original(node);
 		cache::intr_unlock();
 		
+		if(n != node){
+			reset_key_index(n.get());
+		}
+		
 		node_data_ptr data = get_node_data(node);
 		string cur_name = data->path;
 		savior->put(cur_name, SAVE_TYPES::INTR, n);
@@ -1042,6 +2796,7 @@ void forest::details::Tree::d_remove(tree_t::node_ptr& node)
 		savior->remove(data->path, SAVE_TYPES::INTR, n);
 	} else {
 		n->get_childs()->clear();
+		bloom_drop(n.get());
 		savior->remove(data->path, SAVE_TYPES::LEAF, n);
 	}
 	cache::clear_node_cache(node);
@@ -1063,16 +2818,18 @@ void forest::details::Tree::d_reserve(tree_t::node_ptr& node, tree_t::PROCESS_TY
 
 void forest::details::Tree::d_release(tree_t::node_ptr& node, tree_t::PROCESS_TYPE type)
 {	
-	string& path = get_node_data(node)->path;
+	epoch::guard g;
+	string& path = node_data(node.get())->path;
+	tree_t::Node* n;
 	
 	cache::leaf_lock();
 	/// lock{
-	node = get_original(node);
+	n = get_original_raw(node.get());
 	cache::release_leaf_node(path);
 	/// }lock
 	cache::leaf_unlock();
 	
-	change_unlock_type(node, type);
+	change_unlock_type(n, type);
 }
 
 void forest::details::Tree::d_before_move(tree_t::childs_type_iterator& item, int_t step)
@@ -1091,17 +2848,19 @@ void forest::details::Tree::d_after_move(tree_t::childs_type_iterator& item, int
 		return;
 	}
 	
+	epoch::guard g;
 	tree_t::node_ptr node = extract_node(item->data);
-	string& path = get_node_data(node)->path;
+	string& path = node_data(node.get())->path;
+	tree_t::Node* n;
 	
 	cache::leaf_lock();
 	/// lock{
-	node = get_original(node);
+	n = get_original_raw(node.get());
 	cache::release_leaf_node(path);
 	/// }lock
 	cache::leaf_unlock();
 
-	change_unlock_read(node);
+	change_unlock_read(n);
 }
 
 void forest::details::Tree::d_item_reserve(tree_t::child_item_type_ptr& item, tree_t::PROCESS_TYPE type)
@@ -1259,14 +3018,18 @@ void forest::details::Tree::d_offset_release(tree_t::node_ptr& node, int offset)
 		return;
 	}
 	
+	epoch::guard g;
+	string& path = node_data(node.get())->path;
+	tree_t::Node* n;
+	
 	cache::leaf_lock();
 	/// lock{
-	node = get_original(node);
-	cache::release_node(node);
+	n = get_original_raw(node.get());
+	cache::release_leaf_node(path);
 	/// }lock
 	cache::leaf_unlock();
 	
-	change_unlock_read(node);
+	change_unlock_read(n);
 }
 
 void forest::details::Tree::d_leaf_insert(tree_t::node_ptr& node, tree_t::child_item_type_ptr& item)
@@ -1281,6 +3044,12 @@ void forest::details::Tree::d_leaf_insert(tree_t::node_ptr& node, tree_t::child_
 	
 	// Lock both at once
 	change_lock_bunch(node, item, true);
+	
+	if(bloom_bits){
+		bloom_add(node.get(), item->item->first);
+	}
+	
+	count_delta++;
 }
 
 void forest::details::Tree::d_leaf_delete(tree_t::node_ptr& node, tree_t::child_item_type_ptr& item)
@@ -1296,7 +3065,13 @@ void forest::details::Tree::d_leaf_delete(tree_t::node_ptr& node, tree_t::child_
 	// Lock both at once
 	change_lock_bunch(node, item);
 	
-	item->item->second->set_file(nullptr);
+	item->item->second->reset_file();
+	
+	if(hash_index){
+		hash_erase(item->item->first);
+	}
+	
+	count_delta--;
 }
 
 void forest::details::Tree::d_leaf_split(tree_t::node_ptr& node, tree_t::node_ptr& new_node, tree_t::node_ptr& link_node)
@@ -1306,6 +3081,17 @@ void forest::details::Tree::d_leaf_split(tree_t::node_ptr& node, tree_t::node_pt
 		return;
 	}
 	
+	count_nodes.push_back(node.get());
+	count_nodes.push_back(new_node.get());
+	split_left = node.get();
+	split_right = new_node.get();
+	
+	// Keys are moved between the leafs
+	if(bloom_bits){
+		bloom_drop(node.get());
+		bloom_drop(new_node.get());
+	}
+	
 	// Get the original nodes
 	cache::leaf_lock();
 	/// lock{
@@ -1317,6 +3103,8 @@ void forest::details::Tree::d_leaf_split(tree_t::node_ptr& node, tree_t::node_pt
 	
 	// Lock all at once
 	change_lock_bunch(node, new_node, link_node, true);
+	
+	count_restructured = true;
 }
 
 void forest::details::Tree::d_leaf_join(tree_t::node_ptr& node, tree_t::node_ptr& join_node, tree_t::node_ptr& link_node)
@@ -1326,6 +3114,16 @@ void forest::details::Tree::d_leaf_join(tree_t::node_ptr& node, tree_t::node_ptr
 
 void forest::details::Tree::d_leaf_shift(tree_t::node_ptr& node, tree_t::node_ptr& shift_node)
 {	
+	count_nodes.push_back(node.get());
+	count_nodes.push_back(shift_node.get());
+	split_left = node.get();
+	split_right = shift_node.get();
+	
+	if(bloom_bits){
+		bloom_drop(node.get());
+		bloom_drop(shift_node.get());
+	}
+	
 	// Get original nodes
 	cache::leaf_lock();
 	/// lock{
@@ -1336,6 +3134,8 @@ void forest::details::Tree::d_leaf_shift(tree_t::node_ptr& node, tree_t::node_pt
 	
 	// Lock all at once
 	change_lock_bunch(node, shift_node, true);
+	
+	count_restructured = true;
 }
 
 void forest::details::Tree::d_leaf_lock(tree_t::node_ptr& node)
@@ -1346,12 +3146,15 @@ void forest::details::Tree::d_leaf_lock(tree_t::node_ptr& node)
 	
 	ASSERT(has_data(node));
 	
+	epoch::guard g;
+	tree_t::Node* n;
+	
 	cache::leaf_lock();
 	/// lock{
-	node = get_original(node);
+	n = get_original_raw(node.get());
 	/// }lock
 	cache::leaf_unlock();
-	get_data(node).change_locks.m.lock();
+	get_data(n).change_locks.m.lock();
 }
 
 void forest::details::Tree::d_leaf_free(tree_t::node_ptr& node)
@@ -1362,12 +3165,15 @@ void forest::details::Tree::d_leaf_free(tree_t::node_ptr& node)
 	
 	ASSERT(has_data(node));
 	
+	epoch::guard g;
+	tree_t::Node* n;
+	
 	cache::leaf_lock();
 	/// lock{
-	node = get_original(node);
+	n = get_original_raw(node.get());
 	/// }lock
 	cache::leaf_unlock();
-	get_data(node).change_locks.m.unlock();
+	get_data(n).change_locks.m.unlock();
 }
 
 void forest::details::Tree::d_leaf_ref(tree_t::node_ptr& node, tree_t::node_ptr& ref_node, tree_t::LEAF_REF ref)
@@ -10,8 +10,10 @@
 #include <utility>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <future>
 #include <vector>
+#include <array>
 #include <type_traits>
 #include <atomic>
 #include <sstream>
@@ -25,6 +27,10 @@
 #include "node_data.hpp"
 #include "lock.hpp"
 #include "savior.hpp"
+#include "epoch.hpp"
+#include "io.hpp"
+#include "key_search.hpp"
+#include "bloom.hpp"
 
 namespace forest{
 namespace details{
@@ -62,12 +68,36 @@ namespace details{
 			TREE_TYPES get_type();
 			void set_type(TREE_TYPES type);
 			
+			int get_bloom_bits();
+			void set_bloom_bits(int bits);
+			uint_t get_skipped_leafs();
+			
+			bool get_hash_index();
+			void set_hash_index(bool enabled);
+			
 			tree_t* get_tree();
 			void set_tree(tree_t* tree);
 			
 			void insert(tree_t::key_type key, tree_t::val_type val, bool update=false);
 			void erase(tree_t::key_type key);
+			uint_t erase_range(tree_t::key_type from, tree_t::key_type to);
 			tree_t::iterator find(tree_t::key_type key);
+			tree_t::iterator find(LEAF_POSITION position);
+			tree_t::iterator find(tree_t::key_type key, LEAF_POSITION position);
+			bool hash_find(const tree_t::key_type& key, tree_t::val_type& val);
+			void find_batch(const std::vector<tree_t::key_type>& keys, std::vector<tree_t::val_type>& vals);
+			uint_t count_range(tree_t::key_type from, tree_t::key_type to);
+			tree_t::iterator find_at(uint_t index);
+			std::vector<tree_t::key_type> split_range(tree_t::key_type from, tree_t::key_type to, int parts);
+			bool scan_leaf(tree_t::key_type& pos, bool& inclusive, std::vector<tree_t::key_type>& keys, std::vector<tree_t::val_type>& vals, bool forward = true, bool edge = false);
+			
+			void batch_lock();
+			void batch_unlock();
+			void prepare_batch(std::vector<batch_op_t>& ops);
+			void apply_batch(std::vector<batch_op_t>& ops);
+			
+			void add_snapshot(snapshot* snap);
+			void remove_snapshot(snapshot* snap);
 			
 			static string seed(TREE_TYPES type, int factor);
 			static string seed(TREE_TYPES type, string path, int factor);
@@ -77,19 +107,63 @@ namespace details{
 		
 			// Intr methods
 			tree_intr_read_t read_intr(string filename);
-			void materialize_intr(tree_t::node_ptr node);
-			void unmaterialize_intr(tree_t::node_ptr node);
+			void materialize_intr(tree_t::node_ptr& node);
+			void unmaterialize_intr(tree_t::node_ptr& node);
 			
 			// Leaf methods
 			tree_leaf_read_t read_leaf(string filename);
-			void materialize_leaf(tree_t::node_ptr node);
-			void unmaterialize_leaf(tree_t::node_ptr node);
+			void materialize_leaf(tree_t::node_ptr& node);
+			void unmaterialize_leaf(tree_t::node_ptr& node);
 			
 			// Tree methods
 			static tree_base_read_t read_base(string filename);
+			void set_options(const tree_base_read_t& base);
 			static void seed_tree(DBFS::File* file, TREE_TYPES type, int factor);
 			void tree_reserve();
 			void tree_release();
+			void visit_batch(const std::vector<tree_t::key_type>& keys, const std::function<void(uint_t, tree_t::val_type&)>& found);
+			void visit_batch(tree_t::node_ptr node, const std::vector<tree_t::key_type>& keys, uint_t from, uint_t to, const std::function<void(uint_t, tree_t::val_type&)>& found);
+			
+			void scan_leaf(tree_t::node_ptr node, const tree_t::key_type* pos, bool inclusive, bool forward, std::vector<tree_t::key_type>& keys, std::vector<tree_t::val_type>& vals, tree_t::key_type& bound, bool& bounded);
+			bool collect_separators(tree_t::node_ptr node, tree_t::key_type& from, tree_t::key_type& to, int depth, std::vector<tree_t::key_type>& keys);
+			uint_t detach_range(tree_t::key_type& from, tree_t::key_type& to);
+			int_t detach_range(tree_t::node_ptr node, tree_t::key_type& from, tree_t::key_type& to, const tree_t::key_type* lo, const tree_t::key_type* hi, tree_t::node_ptr& last, bool& gap, std::vector<tree_t::node_ptr>& detached);
+			int_t detached_count(tree_t::node_ptr& node, std::vector<tree_t::node_ptr>& detached);
+			int_t leaf_size(const string& path);
+			void relink_leafs(tree_t::node_ptr& left, tree_t::node_ptr& right);
+			
+			// Subtree counts
+			void insert_item(tree_t::key_type& key, tree_t::val_type val, bool update);
+			void erase_item(tree_t::key_type& key);
+			void capture(tree_t::key_type& key);
+			void update_counts(tree_t::key_type& key);
+			void update_counts(tree_t::node_ptr node, tree_t::key_type& key, int_t delta, bool restructured);
+			bool count_changed(tree_t::Node* node);
+			int_t changed_count(tree_t::node_ptr node, bool deep);
+			int_t count_search(std::function<int_t(tree_t::node_ptr&, bool)> search);
+			int_t child_count(tree_t::node_ptr& node, tree_t::node_ptr& child, bool recount);
+			int_t subtree_count(tree_t::node_ptr node);
+			int_t count_less(tree_t::node_ptr node, tree_t::key_type& key, bool recount);
+			uint_t child_index(tree_t::node_ptr& node, const tree_t::key_type& key);
+			void truncate_separator(tree_t::node_ptr& node);
+			bool bloom_excludes(tree_t::Node* leaf, const tree_t::key_type& key);
+			bool bloom_skips(tree_t::node_ptr& node, const std::vector<tree_t::key_type>& keys, uint_t from, uint_t to);
+			bool bloom_skip(tree_t::node_ptr& node);
+			void bloom_build(const string& path, const std::vector<tree_t::key_type>& keys);
+			void bloom_add(tree_t::Node* leaf, const tree_t::key_type& key);
+			void bloom_drop(tree_t::Node* leaf);
+			// Hash index is split by key, every shard has its own lock
+			static const int HASH_SHARDS = 16;
+			struct hash_shard{
+				std::unordered_map<tree_t::key_type, string> map;
+				std::shared_mutex m;
+				uint_t evict = 0;
+			};
+			hash_shard& get_hash_shard(const tree_t::key_type& key);
+			bool hash_read(const string& path, const tree_t::key_type& key, tree_t::val_type& val);
+			void hash_put(const string& path, const tree_t::key_type& key);
+			void hash_erase(const tree_t::key_type& key);
+			int_t key_at(tree_t::node_ptr node, uint_t index, tree_t::key_type& key, bool recount);
 		
 			// Proceed
 			void d_enter(tree_t::node_ptr& node, tree_t::PROCESS_TYPE type);
@@ -118,20 +192,21 @@ namespace details{
 			// Getters
 			tree_t::node_ptr get_intr(string path);
 			tree_t::node_ptr get_leaf(string path);
-			tree_t::node_ptr get_original(tree_t::node_ptr node);
-			tree_t::node_ptr extract_node(tree_t::child_item_type_ptr item);
-			tree_t::node_ptr extract_locked_node(tree_t::child_item_type_ptr item, bool w_prior=false);
+			tree_t::node_ptr get_original(const tree_t::node_ptr& node);
+			tree_t::Node* get_original_raw(tree_t::Node* node);
+			tree_t::node_ptr extract_node(const tree_t::child_item_type_ptr& item);
+			tree_t::node_ptr extract_locked_node(const tree_t::child_item_type_ptr& item, bool w_prior=false);
 			
 			// Savers
 			static void save_intr(node_ptr node, DBFS::File* f);
-			static void save_leaf(node_ptr node, file_ptr fp);
+			static void save_leaf(node_ptr node, vfile_ptr fp);
 			static void save_base(tree_ptr tree, DBFS::File* f);
 			
 			// Writers
 			static void write_intr(DBFS::File* file, tree_intr_read_t data);
 			static void write_base(DBFS::File* file, tree_base_read_t data);
-			static void write_leaf(file_ptr file, tree_leaf_read_t data);
-			static void write_leaf_item(file_ptr file, tree_t::val_type& data);
+			static uint_t write_leaf(DBFS::File* file, tree_leaf_read_t data, int fd=-1);
+			static void write_leaf_items(vfile_ptr vf, DBFS::File* file, std::vector<tree_t::val_type*>& items, uint_t pos, int fd=-1);
 			
 			// Other
 			static tree_t::node_ptr create_node(string path, NODE_TYPES node_type);
@@ -141,7 +216,19 @@ namespace details{
 			TREE_TYPES type;
 			string name;
 			string annotation;
+			int factor;
 			mutex tree_m;
+			std::shared_mutex batch_m;
+			std::shared_mutex count_m;
+			std::atomic<bool> counted{false};
+			std::vector<snapshot*> snapshots;
+			std::shared_mutex snapshots_m;
+			std::atomic<int> bloom_bits{0};
+			std::atomic<uint_t> skipped_leafs{0};
+			ListCache<string, std::shared_ptr<bloom_filter> > leaf_blooms;
+			std::mutex blooms_m;
+			std::atomic<bool> hash_index{false};
+			std::array<hash_shard, HASH_SHARDS> leaf_hash;
 	};
 	
 } // details
@@ -3,7 +3,7 @@
 
 namespace forest{
 	
-	enum class TREE_TYPES { KEY_STRING };
+	enum class TREE_TYPES { KEY_STRING, KEY_INT64, KEY_UINT64 };
 	enum class LEAF_POSITION{ BEGIN, END, LOWER, UPPER };
 	
 namespace details{
@@ -11,6 +11,7 @@ namespace details{
 	enum class KEY_TYPES { STRING };
 	enum class NODE_TYPES { INTR, LEAF };
 	enum class SAVE_TYPES{ LEAF, INTR, BASE };
+	enum class BATCH_OPS{ INSERT, UPDATE, REMOVE };
 	
 	extern int CACHE_BYTES;
 	extern int OPENED_FILES_LIMIT;
@@ -19,6 +20,10 @@ namespace details{
 	class file_data_t;
 	class detached_leaf;
 	class tree_owner;
+	class vfile;
+	class write_batch;
+	class snapshot;
+	class cursor;
 	
 	using string = std::string;
 	using int_t = long long int;
@@ -39,23 +44,31 @@ namespace details{
 	using tree_ptr = std::shared_ptr<Tree>;
 	using node_ptr = tree_t::node_ptr;
 	using file_ptr = std::shared_ptr<DBFS::File>;
+	using vfile_ptr = std::shared_ptr<vfile>;
+	using write_batch_ptr = std::shared_ptr<write_batch>;
+	using snapshot_ptr = std::shared_ptr<snapshot>;
+	using cursor_ptr = std::shared_ptr<cursor>;
 	
 	using child_lengths_vec_ptr = std::vector<uint_t>*;
 	using child_keys_vec_ptr = std::vector<tree_t::key_type>*;
 	using child_values_vec_ptr = std::vector<tree_t::val_type>*;
 	using child_nodes_vec_ptr = std::vector<string>*;
+	using child_counts_vec_ptr = std::vector<int_t>*;
 	
 	struct tree_leaf_read_t {
 		child_keys_vec_ptr child_keys;
 		child_lengths_vec_ptr child_lengths;
 		uint_t start_data;
 		DBFS::File* file;
+		const char* map_data = nullptr;
+		uint_t map_size = 0;
 		string left_leaf, right_leaf;
 	};
 	struct tree_intr_read_t {
 		NODE_TYPES childs_type;
 		child_keys_vec_ptr child_keys;
 		child_nodes_vec_ptr child_values;
+		child_counts_vec_ptr child_counts;
 	};
 	struct tree_base_read_t {
 		TREE_TYPES type;
@@ -64,6 +77,13 @@ namespace details{
 		int factor;
 		string branch;
 		string annotation;
+		int bloom_bits = 0;
+		int hash_index = 0;
+	};
+	struct batch_op_t {
+		BATCH_OPS type;
+		tree_t::key_type key;
+		tree_t::val_type val;
 	};
 	
 } // details
@@ -16,6 +16,10 @@ namespace details{
 	int OPENED_FILES_LIMIT = 50;
 	int SCHEDULE_TIMER = 10000;
 	int SAVIOUR_QUEUE_LENGTH = 50;
+	int ENGINE_WORKERS = 4;
+	bool MMAP_LEAFS = false;
+	bool COMPRESS_KEYS = false;
+	int HASH_INDEX_SIZE = 100000;
 	
 } // details
 } // forest
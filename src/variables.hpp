@@ -23,6 +23,10 @@ namespace details{
 	extern int CHUNK_SIZE;
 	extern int OPENED_FILES_LIMIT;
 	extern int SAVIOUR_QUEUE_LENGTH;
+	extern int ENGINE_WORKERS;
+	extern bool MMAP_LEAFS;
+	extern bool COMPRESS_KEYS;
+	extern int HASH_INDEX_SIZE;
 	
 } // details
 } // forest
@@ -0,0 +1,159 @@
+#include "vfile.hpp"
+#include "io.hpp"
+
+namespace forest{
+namespace details{
+	
+	// Opened files, most recently used first
+	std::list<vfile*> opened_files;
+	std::mutex opened_files_m;
+	
+} // details
+} // forest
+
+forest::details::vfile::vfile(string name) : fname(name)
+{
+	// ctor
+}
+
+forest::details::vfile::vfile(string name, DBFS::File* file) : fname(name), file(file)
+{
+	std::lock_guard<std::mutex> lock(m);
+	attach();
+	shrink(this);
+}
+
+forest::details::vfile::~vfile()
+{
+	{
+		std::lock_guard<std::mutex> lock(m);
+		release();
+		io::unmap(map_data, map_size);
+	}
+	for(auto& fn : callbacks){
+		fn(this);
+	}
+}
+
+forest::details::string forest::details::vfile::name()
+{
+	std::lock_guard<std::mutex> lock(m);
+	return fname;
+}
+
+forest::details::vfile::handle forest::details::vfile::open()
+{
+	std::unique_lock<std::mutex> lock(m);
+	
+	if(!file){
+		file = new DBFS::File(fname);
+		if(file->fail()){
+			L_ERR("[vfile::open]-(cannot open file)");
+			delete file;
+			file = nullptr;
+			throw TreeException(TreeException::ERRORS::CANNOT_READ_FILE);
+		}
+		attach();
+	} else {
+		std::lock_guard<std::mutex> plock(opened_files_m);
+		opened_files.splice(opened_files.begin(), opened_files, pos);
+	}
+	
+	shrink(this);
+	
+	return handle{std::move(lock), file, fd};
+}
+
+void forest::details::vfile::close()
+{
+	std::lock_guard<std::mutex> lock(m);
+	release();
+}
+
+void forest::details::vfile::move(string new_name)
+{
+	std::lock_guard<std::mutex> lock(m);
+	if(file){
+		file->move(new_name);
+	} else {
+		DBFS::move(fname, new_name);
+	}
+	fname = new_name;
+}
+
+void forest::details::vfile::on_close(close_fn fn)
+{
+	std::lock_guard<std::mutex> lock(m);
+	callbacks.push_back(fn);
+}
+
+void forest::details::vfile::set_mapping(const char* data, uint_t size)
+{
+	std::lock_guard<std::mutex> lock(m);
+	io::unmap(map_data, map_size);
+	map_data = data;
+	map_size = size;
+}
+
+const char* forest::details::vfile::mapped_data()
+{
+	return map_data;
+}
+
+forest::details::uint_t forest::details::vfile::mapped_size()
+{
+	return map_size;
+}
+
+void forest::details::vfile::attach()
+{
+	fd = io::open(fname);
+	
+	std::lock_guard<std::mutex> plock(opened_files_m);
+	opened_files.push_front(this);
+	pos = opened_files.begin();
+	opened_files_count++;
+}
+
+void forest::details::vfile::release()
+{
+	if(!file){
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> plock(opened_files_m);
+		opened_files.erase(pos);
+		opened_files_count--;
+	}
+	io::close(fd);
+	fd = -1;
+	file->close();
+	delete file;
+	file = nullptr;
+}
+
+void forest::details::vfile::shrink(vfile* keep)
+{
+	std::lock_guard<std::mutex> plock(opened_files_m);
+	
+	auto it = opened_files.end();
+	while((int)opened_files.size() > OPENED_FILES_LIMIT && it != opened_files.begin()){
+		--it;
+		vfile* vf = *it;
+		
+		// Skip files that are in use right now
+		if(vf == keep || !vf->m.try_lock()){
+			continue;
+		}
+		
+		auto next = opened_files.erase(it);
+		opened_files_count--;
+		io::close(vf->fd);
+		vf->fd = -1;
+		vf->file->close();
+		delete vf->file;
+		vf->file = nullptr;
+		vf->m.unlock();
+		it = next;
+	}
+}
@@ -0,0 +1,65 @@
+#ifndef FOREST_VFILE_H
+#define FOREST_VFILE_H
+
+#include <list>
+#include <vector>
+#include "dbutils.hpp"
+
+namespace forest{
+namespace details{
+	
+	extern std::atomic<int> opened_files_count;
+	extern int OPENED_FILES_LIMIT;
+	
+	// Virtual file handle.
+	// Real file is opened on demand and could be closed at any time
+	// when the number of opened files exceeds OPENED_FILES_LIMIT.
+	class vfile{
+		
+		using close_fn = std::function<void(vfile*)>;
+		
+		public:
+			struct handle{
+				std::unique_lock<std::mutex> lock;
+				DBFS::File* file;
+				int fd;
+				DBFS::File* operator->(){ return file; }
+			};
+			
+			vfile(string name);
+			vfile(string name, DBFS::File* file);
+			virtual ~vfile();
+			
+			string name();
+			handle open();
+			void close();
+			void move(string new_name);
+			void on_close(close_fn fn);
+			void set_mapping(const char* data, uint_t size);
+			const char* mapped_data();
+			uint_t mapped_size();
+			
+		private:
+			void attach();
+			void release();
+			static void shrink(vfile* keep);
+			
+			std::mutex m;
+			string fname;
+			DBFS::File* file = nullptr;
+			
+			// Own descriptor for positional io, opened and closed with the file
+			int fd = -1;
+			
+			// Mapped bytes are kept until the vfile is destroyed,
+			// they survive closing, moving and unlinking of the file
+			const char* map_data = nullptr;
+			uint_t map_size = 0;
+			std::list<vfile*>::iterator pos;
+			std::vector<close_fn> callbacks;
+	};
+	
+} // details
+} // forest
+
+#endif // FOREST_VFILE_H
@@ -0,0 +1,68 @@
+#include "write_batch.hpp"
+
+forest::details::write_batch::write_batch()
+{
+	// ctor
+}
+
+forest::details::write_batch::~write_batch()
+{
+	// dtor
+}
+
+void forest::details::write_batch::insert_leaf(string tree_name, tree_t::key_type key, detached_leaf_ptr val)
+{
+	add(tree_name, nullptr, BATCH_OPS::INSERT, key, val);
+}
+
+void forest::details::write_batch::update_leaf(string tree_name, tree_t::key_type key, detached_leaf_ptr val)
+{
+	add(tree_name, nullptr, BATCH_OPS::UPDATE, key, val);
+}
+
+void forest::details::write_batch::remove_leaf(string tree_name, tree_t::key_type key)
+{
+	add(tree_name, nullptr, BATCH_OPS::REMOVE, key, nullptr);
+}
+
+void forest::details::write_batch::insert_leaf(tree_owner_ptr tree, tree_t::key_type key, detached_leaf_ptr val)
+{
+	add("", tree, BATCH_OPS::INSERT, key, val);
+}
+
+void forest::details::write_batch::update_leaf(tree_owner_ptr tree, tree_t::key_type key, detached_leaf_ptr val)
+{
+	add("", tree, BATCH_OPS::UPDATE, key, val);
+}
+
+void forest::details::write_batch::remove_leaf(tree_owner_ptr tree, tree_t::key_type key)
+{
+	add("", tree, BATCH_OPS::REMOVE, key, nullptr);
+}
+
+forest::details::uint_t forest::details::write_batch::size()
+{
+	std::lock_guard<mutex> lock(batch_m);
+	return entries.size();
+}
+
+void forest::details::write_batch::clear()
+{
+	std::lock_guard<mutex> lock(batch_m);
+	entries.clear();
+}
+
+void forest::details::write_batch::add(string tree_name, tree_owner_ptr tree, BATCH_OPS type, tree_t::key_type& key, detached_leaf_ptr val)
+{
+	batch_entry entry;
+	entry.tree_name = tree_name;
+	entry.tree = tree;
+	entry.op.type = type;
+	entry.op.key = key;
+	if(val){
+		entry.op.val = extract_leaf_val(val);
+	}
+	
+	std::lock_guard<mutex> lock(batch_m);
+	entries.push_back(entry);
+}
@@ -0,0 +1,48 @@
+#ifndef FOREST_WRITE_BATCH_H
+#define FOREST_WRITE_BATCH_H
+
+#include "dbutils.hpp"
+#include "tree_owner.hpp"
+#include "detached_leaf.hpp"
+
+namespace forest{
+namespace details{
+	
+	class write_batch{
+		
+		friend void apply_batch(write_batch_ptr batch);
+		
+		public:
+			write_batch();
+			virtual ~write_batch();
+			
+			void insert_leaf(string tree_name, tree_t::key_type key, detached_leaf_ptr val);
+			void update_leaf(string tree_name, tree_t::key_type key, detached_leaf_ptr val);
+			void remove_leaf(string tree_name, tree_t::key_type key);
+			
+			void insert_leaf(tree_owner_ptr tree, tree_t::key_type key, detached_leaf_ptr val);
+			void update_leaf(tree_owner_ptr tree, tree_t::key_type key, detached_leaf_ptr val);
+			void remove_leaf(tree_owner_ptr tree, tree_t::key_type key);
+			
+			uint_t size();
+			void clear();
+			
+		private:
+			struct batch_entry{
+				string tree_name;
+				tree_owner_ptr tree;
+				batch_op_t op;
+			};
+			
+			void add(string tree_name, tree_owner_ptr tree, BATCH_OPS type, tree_t::key_type& key, detached_leaf_ptr val);
+			
+			std::vector<batch_entry> entries;
+			mutex batch_m;
+	};
+	
+	void apply_batch(write_batch_ptr batch);
+	
+} // details
+} // forest
+
+#endif // FOREST_WRITE_BATCH_H
@@ -0,0 +1,180 @@
+
+DESCRIBE("Test execution engine", {
+	DESCRIBE("Initialize forest at tmp/t3", {
+		
+		BEFORE_ALL({
+			config_low();
+			forest::config_engine_workers(4);
+			forest::bloom("tmp/t3");
+		});
+		
+		AFTER_ALL({
+			forest::fold();
+		});
+		
+		DESCRIBE("Add 10 trees and fill them in 10 threads", {
+			BEFORE_ALL({
+				for(int i=0;i<10;i++){
+					forest::plant_tree(forest::TREE_TYPES::KEY_STRING, "engine_"+to_string(i));
+				}
+				vector<thread> trds;
+				for(int i=0;i<10;i++){
+					thread t([](int i){
+						for(int j=0;j<100;j++){
+							forest::insert_leaf("engine_"+to_string(j%10), "k"+to_string(i*100+j), forest::make_leaf("v"+to_string(i*100+j)));
+						}
+					},i);
+					trds.push_back(move(t));
+				}
+				for(auto& it : trds){
+					it.join();
+				}
+			});
+			
+			AFTER_ALL({
+				for(int i=0;i<10;i++){
+					forest::cut_tree("engine_"+to_string(i));
+				}
+			});
+			
+			IT("All leafs should be found", {
+				for(int i=0;i<1000;i++){
+					auto leaf = forest::find_leaf("engine_"+to_string(i%10), "k"+to_string(i));
+					EXPECT(read_leaf(leaf->val())).toBe("v"+to_string(i));
+				}
+			});
+			
+			IT("Every tree should contain 100 leafs", {
+				for(int i=0;i<10;i++){
+					int cnt = 0;
+					auto it = forest::find_leaf("engine_"+to_string(i));
+					do{
+						cnt++;
+					}while(it->move_forward());
+					EXPECT(cnt).toBe(100);
+				}
+			});
+			
+			IT("Errors should be passed to the caller", {
+				EXPECT([](){
+					forest::find_leaf("engine_0", forest::LEAF_POSITION::LOWER);
+				}).toThrowError();
+			});
+		});
+		
+		DESCRIBE("Add `async` tree and fill it with async calls", {
+			BEFORE_ALL({
+				forest::plant_tree(forest::TREE_TYPES::KEY_STRING, "async");
+				vector<std::future<void>> res;
+				for(int i=0;i<200;i++){
+					res.push_back(forest::async_insert_leaf("async", "k"+to_string(i), forest::make_leaf("v"+to_string(i))));
+				}
+				for(auto& it : res){
+					it.get();
+				}
+			});
+			
+			AFTER_ALL({
+				forest::cut_tree("async");
+			});
+			
+			IT("All leafs should be found asynchronously", {
+				forest::Tree tree = forest::find_tree("async");
+				vector<std::future<forest::Leaf>> res;
+				for(int i=0;i<200;i++){
+					res.push_back(forest::async_find_leaf(tree, "k"+to_string(i)));
+				}
+				for(int i=0;i<200;i++){
+					EXPECT(read_leaf(res[i].get()->val())).toBe("v"+to_string(i));
+				}
+			});
+			
+			IT("Updated and removed leafs should be changed", {
+				forest::async_update_leaf("async", "k10", forest::make_leaf("new")).get();
+				forest::async_remove_leaf("async", "k11").get();
+				EXPECT(read_leaf(forest::async_find_leaf("async", "k10").get()->val())).toBe("new");
+				EXPECT([](){
+					forest::async_find_leaf("async", "k11").get();
+				}).toThrowError();
+			});
+			
+			IT("Errors should be passed to the future", {
+				auto res = forest::async_find_leaf("async", forest::LEAF_POSITION::LOWER);
+				EXPECT([&res](){
+					res.get();
+				}).toThrowError();
+			});
+			
+			IT("Calls on one tree should run on every worker", {
+				std::mutex m;
+				std::condition_variable cv;
+				vector<std::thread::id> ids;
+				int started = 0;
+				vector<future<int>> res;
+				for(int i=0;i<4;i++){
+					res.push_back(forest::details::engine->dispatch<int>([&](){
+						std::unique_lock<std::mutex> lock(m);
+						ids.push_back(std::this_thread::get_id());
+						started++;
+						cv.notify_all();
+						// Every call waits for the others, so they could not share a worker
+						cv.wait_for(lock, std::chrono::seconds(1), [&started](){ return started == 4; });
+						return 0;
+					}));
+				}
+				for(auto& it : res){
+					it.get();
+				}
+				sort(ids.begin(), ids.end());
+				EXPECT((int)(unique(ids.begin(), ids.end()) - ids.begin())).toBe(4);
+			});
+		});
+		
+		DESCRIBE("Add `scan` tree with 1000 leafs", {
+			BEFORE_ALL({
+				forest::plant_tree(forest::TREE_TYPES::KEY_STRING, "scan");
+				for(int i=0;i<1000;i++){
+					forest::insert_leaf("scan", "k"+to_string(1000+i), forest::make_leaf("v"+to_string(i)));
+				}
+			});
+			
+			AFTER_ALL({
+				forest::cut_tree("scan");
+			});
+			
+			IT("parallel_scan should visit every leaf of the range once", {
+				std::mutex m;
+				vector<string> keys;
+				forest::parallel_scan("scan", "k1100", "k1900", 4, [&m, &keys](int part, forest::Leaf leaf){
+					std::lock_guard<std::mutex> lock(m);
+					keys.push_back(leaf->key());
+					return true;
+				});
+				sort(keys.begin(), keys.end());
+				EXPECT((int)keys.size()).toBe(800);
+				for(int i=0;i<(int)keys.size();i++){
+					EXPECT(keys[i]).toBe("k"+to_string(1100+i));
+				}
+			});
+			
+			IT("parallel_scan part should stop when callback returns false", {
+				std::atomic<int> cnt(0);
+				forest::parallel_scan(forest::find_tree("scan"), "k1000", "k2000", 1, [&cnt](int part, forest::Leaf leaf){
+					return ++cnt < 10;
+				});
+				EXPECT(cnt.load()).toBe(10);
+			});
+			
+			IT("parallel_scan callback should be able to call other operations", {
+				std::atomic<int> cnt(0);
+				forest::parallel_scan("scan", "k1000", "k1400", 4, [&cnt](int part, forest::Leaf leaf){
+					if(read_leaf(forest::find_leaf("scan", leaf->key())->val()) == read_leaf(leaf->val())){
+						cnt++;
+					}
+					return true;
+				});
+				EXPECT(cnt.load()).toBe(400);
+			});
+		});
+	});
+});
@@ -312,5 +312,101 @@ DESCRIBE("Initialize forest at tmp/perf", {
 				forest::fold();
 			});
 		});
+		
+		DESCRIBE("In-node key search", {
+			int lookups = 1000000;
+			
+			IT("Compare string keys search at factors 100 and 500", {
+				for(int factor : {100, 500}){
+					vector<string> keys, probes;
+					vector<std::uint64_t> prefixes;
+					for(int i=0;i<factor;i++){
+						keys.push_back(to_str(i * 37));
+						prefixes.push_back(forest::details::key_prefix(keys.back()));
+					}
+					for(int i=0;i<1000;i++){
+						probes.push_back(to_str(rand() % (factor * 37)));
+					}
+					size_t sum_std = 0, sum_scalar = 0, sum_packed = 0;
+					
+					p1 = chrono::system_clock::now();
+					for(int i=0;i<lookups;i++){
+						const string& key = probes[i % probes.size()];
+						sum_std += upper_bound(keys.begin(), keys.end(), key) - keys.begin();
+					}
+					p2 = chrono::system_clock::now();
+					INFO_PRINT("Factor " + to_string(factor) + ", time for std::upper_bound: " + to_string(chrono::duration_cast<chrono::milliseconds>(p2-p1).count()) + "ms");
+					
+					// Same prefixes searched by the scalar binary search only
+					p1 = chrono::system_clock::now();
+					for(int i=0;i<lookups;i++){
+						const string& key = probes[i % probes.size()];
+						std::uint64_t p = forest::details::key_prefix(key);
+						auto hi = upper_bound(prefixes.begin(), prefixes.end(), p);
+						auto lo = lower_bound(prefixes.begin(), hi, p);
+						sum_scalar += (lo == hi) ? hi - prefixes.begin() : upper_bound(keys.begin() + (lo - prefixes.begin()), keys.begin() + (hi - prefixes.begin()), key) - keys.begin();
+					}
+					p2 = chrono::system_clock::now();
+					INFO_PRINT("Factor " + to_string(factor) + ", time for scalar prefixes: " + to_string(chrono::duration_cast<chrono::milliseconds>(p2-p1).count()) + "ms");
+					
+					p1 = chrono::system_clock::now();
+					for(int i=0;i<lookups;i++){
+						const string& key = probes[i % probes.size()];
+						std::uint64_t p = forest::details::key_prefix(key);
+						size_t hi = forest::details::prefix_rank(prefixes.data(), prefixes.size(), p, true);
+						size_t lo = forest::details::prefix_rank(prefixes.data(), hi, p, false);
+						sum_packed += (lo == hi) ? hi : upper_bound(keys.begin() + lo, keys.begin() + hi, key) - keys.begin();
+					}
+					p2 = chrono::system_clock::now();
+					INFO_PRINT("Factor " + to_string(factor) + ", time for packed prefixes: " + to_string(chrono::duration_cast<chrono::milliseconds>(p2-p1).count()) + "ms");
+					
+					EXPECT(sum_scalar == sum_std).toBe(true);
+					EXPECT(sum_packed == sum_std).toBe(true);
+				}
+			});
+			
+			IT("Compare integer keys search at factors 100 and 500", {
+				for(int factor : {100, 500}){
+					vector<string> keys, probes;
+					vector<std::uint64_t> ints;
+					for(int i=0;i<factor;i++){
+						ints.push_back((std::uint64_t)i * 37);
+						keys.push_back(forest::uint_key(ints.back()));
+					}
+					for(int i=0;i<1000;i++){
+						probes.push_back(forest::uint_key(rand() % (factor * 37)));
+					}
+					size_t sum_std = 0, sum_scalar = 0, sum_packed = 0;
+					
+					p1 = chrono::system_clock::now();
+					for(int i=0;i<lookups;i++){
+						const string& key = probes[i % probes.size()];
+						sum_std += upper_bound(keys.begin(), keys.end(), key) - keys.begin();
+					}
+					p2 = chrono::system_clock::now();
+					INFO_PRINT("Factor " + to_string(factor) + ", time for std::upper_bound: " + to_string(chrono::duration_cast<chrono::milliseconds>(p2-p1).count()) + "ms");
+					
+					// Same integers searched by the scalar binary search only
+					p1 = chrono::system_clock::now();
+					for(int i=0;i<lookups;i++){
+						std::uint64_t v = forest::key_to_uint(probes[i % probes.size()]);
+						sum_scalar += upper_bound(ints.begin(), ints.end(), v) - ints.begin();
+					}
+					p2 = chrono::system_clock::now();
+					INFO_PRINT("Factor " + to_string(factor) + ", time for scalar integers: " + to_string(chrono::duration_cast<chrono::milliseconds>(p2-p1).count()) + "ms");
+					
+					p1 = chrono::system_clock::now();
+					for(int i=0;i<lookups;i++){
+						std::uint64_t v = forest::key_to_uint(probes[i % probes.size()]);
+						sum_packed += forest::details::prefix_rank(ints.data(), ints.size(), v, true);
+					}
+					p2 = chrono::system_clock::now();
+					INFO_PRINT("Factor " + to_string(factor) + ", time for packed integers: " + to_string(chrono::duration_cast<chrono::milliseconds>(p2-p1).count()) + "ms");
+					
+					EXPECT(sum_scalar == sum_std).toBe(true);
+					EXPECT(sum_packed == sum_std).toBe(true);
+				}
+			});
+		});
 	});
 });
@@ -109,6 +109,19 @@ DESCRIBE("Test single thread", {
 				EXPECT([&record](){record->key();}).toThrowError();
 			});
 			
+			IT("Reader view should return the whole value", {
+				forest::insert_leaf("test", "a", forest::make_leaf("value_a"));
+				forest::insert_leaf("test", "b", forest::make_leaf(std::string(10000, 'b')));
+				{
+					auto reader = forest::find_leaf("test", "a")->val()->get_reader();
+					EXPECT(std::string(reader.view())).toBe("value_a");
+				}
+				auto val = forest::find_leaf("test", "b")->val();
+				auto reader = val->get_reader();
+				EXPECT(std::string(reader.view())).toBe(std::string(10000, 'b'));
+				EXPECT(reader.view().data() == reader.view().data()).toBe(true);
+			});
+			
 			IT("Finding leaf using incorrect parameters should throw", {
 				EXPECT([](){
 					forest::find_leaf("test", forest::LEAF_POSITION::LOWER);
@@ -240,6 +253,631 @@ DESCRIBE("Test single thread", {
 			});
 		});
 		
+		DESCRIBE("Add `batch` tree with 200 leafs", {
+			BEFORE_ALL({
+				forest::plant_tree(forest::TREE_TYPES::KEY_STRING, "batch");
+				for(int i=0;i<200;i++){
+					forest::insert_leaf("batch", "k"+std::to_string(i), forest::make_leaf("value_" + std::to_string(i)));
+				}
+			});
+			
+			AFTER_ALL({
+				forest::cut_tree("batch");
+			});
+			
+			IT("find_leafs should return leafs in the input order", {
+				vector<string> keys;
+				for(int i=0;i<300;i+=3){
+					keys.push_back("k"+std::to_string(i));
+				}
+				for(int i=0;i<(int)keys.size();i++){
+					swap(keys[i], keys[rand()%keys.size()]);
+				}
+				auto leafs = forest::find_leafs("batch", keys);
+				EXPECT(leafs.size()).toBe(keys.size());
+				for(int i=0;i<(int)keys.size();i++){
+					int num = std::stoi(keys[i].substr(1));
+					if(num < 200){
+						EXPECT(leafs[i]->key()).toBe(keys[i]);
+						EXPECT(read_leaf(leafs[i]->val())).toBe("value_" + std::to_string(num));
+					} else {
+						EXPECT(leafs[i]->eof()).toBe(true);
+					}
+				}
+			});
+			
+			IT("leafs from find_leafs should move like regular leafs", {
+				auto leafs = forest::find_leafs(forest::find_tree("batch"), {"k10", "k150"});
+				EXPECT(leafs[0]->move_forward()).toBe(true);
+				EXPECT(leafs[0]->key()).toBe("k100");
+				EXPECT(leafs[1]->move_back()).toBe(true);
+				EXPECT(leafs[1]->key()).toBe("k15");
+			});
+		});
+		
+		DESCRIBE("Write batch to `wb_1` and `wb_2` trees", {
+			BEFORE_ALL({
+				forest::plant_tree(forest::TREE_TYPES::KEY_STRING, "wb_1");
+				forest::plant_tree(forest::TREE_TYPES::KEY_STRING, "wb_2");
+				for(int i=0;i<50;i++){
+					forest::insert_leaf("wb_1", "k"+std::to_string(i), forest::make_leaf("old_" + std::to_string(i)));
+				}
+			});
+			
+			AFTER_ALL({
+				forest::cut_tree("wb_1");
+				forest::cut_tree("wb_2");
+			});
+			
+			IT("should apply all of the batch mutations", {
+				forest::WriteBatch batch = forest::make_batch();
+				forest::Tree wb_2 = forest::find_tree("wb_2");
+				for(int i=0;i<50;i++){
+					if(i%2){
+						batch->remove_leaf("wb_1", "k"+std::to_string(i));
+					} else {
+						batch->update_leaf("wb_1", "k"+std::to_string(i), forest::make_leaf("new_" + std::to_string(i)));
+					}
+					batch->insert_leaf(wb_2, "k"+std::to_string(i), forest::make_leaf("value_" + std::to_string(i)));
+				}
+				EXPECT((int)batch->size()).toBe(100);
+				forest::write(batch);
+				
+				for(int i=0;i<50;i++){
+					if(i%2){
+						EXPECT([i](){ forest::find_leaf("wb_1", "k"+std::to_string(i)); }).toThrowError();
+					} else {
+						EXPECT(read_leaf(forest::find_leaf("wb_1", "k"+std::to_string(i))->val())).toBe("new_" + std::to_string(i));
+					}
+					EXPECT(read_leaf(forest::find_leaf(wb_2, "k"+std::to_string(i))->val())).toBe("value_" + std::to_string(i));
+				}
+			});
+			
+			IT("should apply mutations of the same key in order", {
+				forest::WriteBatch batch = forest::make_batch();
+				batch->insert_leaf("wb_2", "same", forest::make_leaf("first"));
+				batch->update_leaf("wb_2", "same", forest::make_leaf("second"));
+				forest::write(batch);
+				EXPECT(read_leaf(forest::find_leaf("wb_2", "same")->val())).toBe("second");
+			});
+			
+			IT("should fold mutations of the same key into one", {
+				forest::WriteBatch batch = forest::make_batch();
+				batch->insert_leaf("wb_2", "folded", forest::make_leaf("first"));
+				batch->remove_leaf("wb_2", "folded");
+				batch->insert_leaf("wb_2", "folded", forest::make_leaf("second"));
+				batch->remove_leaf("wb_2", "gone");
+				batch->insert_leaf("wb_2", "gone", forest::make_leaf("value"));
+				batch->remove_leaf("wb_2", "gone");
+				forest::write(batch);
+				EXPECT(read_leaf(forest::find_leaf("wb_2", "folded")->val())).toBe("second");
+				EXPECT([](){ forest::find_leaf("wb_2", "gone"); }).toThrowError();
+			});
+			
+			IT("should skip operations that change nothing", {
+				forest::WriteBatch batch = forest::make_batch();
+				batch->remove_leaf("wb_1", "k1");
+				batch->insert_leaf("wb_1", "k0", forest::make_leaf("ignored"));
+				batch->insert_leaf("wb_1", "k1", forest::make_leaf("back"));
+				batch->remove_leaf("wb_1", "k2");
+				forest::write(batch);
+				EXPECT(read_leaf(forest::find_leaf("wb_1", "k0")->val())).toBe("new_0");
+				EXPECT(read_leaf(forest::find_leaf("wb_1", "k1")->val())).toBe("back");
+				EXPECT([](){ forest::find_leaf("wb_1", "k2"); }).toThrowError();
+				EXPECT((int)forest::count_range("wb_1", "k", "l")).toBe(25);
+			});
+			
+			IT("should fail without changes if tree does not exist", {
+				forest::WriteBatch batch = forest::make_batch();
+				batch->insert_leaf("wb_2", "missing", forest::make_leaf("value"));
+				batch->insert_leaf("wb_none", "missing", forest::make_leaf("value"));
+				EXPECT([&batch](){ forest::write(batch); }).toThrowError();
+				EXPECT([](){ forest::find_leaf("wb_2", "missing"); }).toThrowError();
+			});
+		});
+		
+		DESCRIBE("Remove range from `range` tree with 100 leafs", {
+			BEFORE_ALL({
+				forest::plant_tree(forest::TREE_TYPES::KEY_STRING, "range");
+				for(int i=0;i<100;i++){
+					forest::insert_leaf("range", "k"+std::to_string(100+i), forest::make_leaf("value_" + std::to_string(i)));
+				}
+			});
+			
+			AFTER_ALL({
+				forest::cut_tree("range");
+			});
+			
+			IT("should remove only leafs inside of the range", {
+				EXPECT((int)forest::remove_range("range", "k120", "k180")).toBe(60);
+				forest::Leaf leaf = forest::find_leaf("range", "k119");
+				EXPECT(leaf->move_forward()).toBe(true);
+				EXPECT(leaf->key()).toBe("k180");
+				EXPECT([](){ forest::find_leaf("range", "k150"); }).toThrowError();
+			});
+			
+			IT("should remove nothing for the empty range", {
+				EXPECT((int)forest::remove_range(forest::find_tree("range"), "k150", "k160")).toBe(0);
+				EXPECT((int)forest::remove_range("range", "k190", "k110")).toBe(0);
+			});
+			
+			IT("should keep the tree whole after a wide range is removed", {
+				for(int i=0;i<3000;i++){
+					forest::insert_leaf("range", "w"+std::to_string(10000+i), forest::make_leaf("value_" + std::to_string(i)));
+				}
+				EXPECT((int)forest::remove_range("range", "w10500", "w12500")).toBe(2000);
+				EXPECT((int)forest::count_range("range", "w10000", "w20000")).toBe(1000);
+				forest::Leaf leaf = forest::find_leaf("range", "w10499");
+				EXPECT(leaf->move_forward()).toBe(true);
+				EXPECT(leaf->key()).toBe("w12500");
+				EXPECT(leaf->move_back()).toBe(true);
+				EXPECT(leaf->key()).toBe("w10499");
+				EXPECT([](){ forest::find_leaf("range", "w11500"); }).toThrowError();
+				forest::insert_leaf("range", "w11500", forest::make_leaf("value"));
+				EXPECT(read_leaf(forest::find_leaf("range", "w11500")->val())).toBe("value");
+			});
+		});
+		
+		DESCRIBE("Count leafs of `stats` tree with 500 leafs", {
+			BEFORE_ALL({
+				forest::plant_tree(forest::TREE_TYPES::KEY_STRING, "stats");
+				for(int i=0;i<500;i++){
+					forest::insert_leaf("stats", "k"+std::to_string(1000+i), forest::make_leaf("value_" + std::to_string(i)));
+				}
+			});
+			
+			AFTER_ALL({
+				forest::cut_tree("stats");
+			});
+			
+			IT("count_range should count leafs inside of the range", {
+				EXPECT((int)forest::count_range("stats", "k1000", "k1500")).toBe(500);
+				EXPECT((int)forest::count_range("stats", "k1100", "k1250")).toBe(150);
+				EXPECT((int)forest::count_range("stats", "k1250", "k1100")).toBe(0);
+			});
+			
+			IT("find_leaf_at should return leaf by its position", {
+				EXPECT(forest::find_leaf_at("stats", 0)->key()).toBe("k1000");
+				EXPECT(forest::find_leaf_at(forest::find_tree("stats"), 321)->key()).toBe("k1321");
+				EXPECT(forest::find_leaf_at("stats", 500)->eof()).toBe(true);
+			});
+			
+			IT("counts should follow further changes", {
+				for(int i=0;i<500;i+=2){
+					forest::remove_leaf("stats", "k"+std::to_string(1000+i));
+				}
+				for(int i=0;i<100;i++){
+					forest::insert_leaf("stats", "k"+std::to_string(2000+i), forest::make_leaf("value"));
+				}
+				EXPECT((int)forest::count_range("stats", "k1000", "k1500")).toBe(250);
+				EXPECT((int)forest::count_range("stats", "k1100", "k2050")).toBe(250);
+				EXPECT(forest::find_leaf_at("stats", 300)->key()).toBe("k2050");
+			});
+			
+			IT("counts should follow splits of internal nodes", {
+				for(int i=0;i<2000;i++){
+					forest::insert_leaf("stats", "k"+std::to_string(3000+i), forest::make_leaf("value"));
+					if(i % 500 == 0){
+						EXPECT((int)forest::count_range("stats", "k3000", "k5000")).toBe(i+1);
+					}
+				}
+				EXPECT((int)forest::count_range("stats", "k3000", "k5000")).toBe(2000);
+				EXPECT((int)forest::count_range("stats", "k1000", "k5000")).toBe(2350);
+				EXPECT(forest::find_leaf_at("stats", 1350)->key()).toBe("k4000");
+				for(int i=0;i<2000;i+=2){
+					forest::remove_leaf("stats", "k"+std::to_string(3000+i));
+				}
+				EXPECT((int)forest::count_range("stats", "k3000", "k5000")).toBe(1000);
+				EXPECT(forest::find_leaf_at("stats", 350)->key()).toBe("k3001");
+			});
+			
+			IT("counts should not change on update", {
+				for(int i=0;i<100;i++){
+					forest::update_leaf("stats", "k"+std::to_string(2000+i), forest::make_leaf("updated"));
+				}
+				EXPECT((int)forest::count_range("stats", "k1000", "k1500")).toBe(250);
+				EXPECT((int)forest::count_range("stats", "k1100", "k2050")).toBe(250);
+				EXPECT(forest::find_leaf_at("stats", 300)->key()).toBe("k2050");
+			});
+		});
+		
+		DESCRIBE("Add `bloom` tree with bloom filters", {
+			BEFORE_ALL({
+				forest::plant_tree(forest::TREE_TYPES::KEY_STRING, "bloom");
+				forest::set_bloom_filter("bloom", 0.01);
+				for(int i=0;i<300;i+=2){
+					forest::insert_leaf("bloom", "k"+std::to_string(100+i), forest::make_leaf("v" + std::to_string(i)));
+				}
+			});
+			
+			AFTER_ALL({
+				forest::cut_tree("bloom");
+			});
+			
+			IT("should find existing leafs and throw for missing ones", {
+				for(int round=0;round<2;round++){
+					for(int i=0;i<300;i++){
+						string key = "k"+std::to_string(100+i);
+						if(i % 2){
+							EXPECT([&key](){ forest::find_leaf("bloom", key); }).toThrowError();
+						} else {
+							EXPECT(read_leaf(forest::find_leaf("bloom", key)->val())).toBe("v" + std::to_string(i));
+						}
+					}
+				}
+			});
+			
+			IT("missing keys should not read their leafs", {
+				forest::details::tree_ptr tree = forest::details::extract_native_tree(forest::find_tree("bloom"));
+				forest::details::uint_t skipped = tree->get_skipped_leafs();
+				for(int i=1;i<250;i+=2){
+					string key = "k"+std::to_string(100+i);
+					EXPECT([&key](){ forest::find_leaf("bloom", key); }).toThrowError();
+				}
+				// False positives read the leaf anyway
+				EXPECT(tree->get_skipped_leafs() - skipped > 115).toBe(true);
+				EXPECT(read_leaf(forest::find_leaf("bloom", "k398")->val())).toBe("v298");
+			});
+			
+			IT("should find leafs inserted after filters were built", {
+				for(int i=1;i<300;i+=4){
+					forest::insert_leaf("bloom", "k"+std::to_string(100+i), forest::make_leaf("n" + std::to_string(i)));
+				}
+				for(int i=1;i<300;i+=4){
+					EXPECT(read_leaf(forest::find_leaf("bloom", "k"+std::to_string(100+i))->val())).toBe("n" + std::to_string(i));
+				}
+			});
+		});
+		
+		DESCRIBE("Add `hashed` tree with hash index", {
+			BEFORE_ALL({
+				forest::plant_tree(forest::TREE_TYPES::KEY_STRING, "hashed");
+				forest::set_hash_index("hashed", true);
+				for(int i=0;i<500;i+=2){
+					forest::insert_leaf("hashed", "k"+std::to_string(1000+i), forest::make_leaf("v" + std::to_string(i)));
+				}
+			});
+			
+			AFTER_ALL({
+				forest::cut_tree("hashed");
+			});
+			
+			IT("should find leafs through the index", {
+				for(int round=0;round<2;round++){
+					for(int i=0;i<500;i++){
+						string key = "k"+std::to_string(1000+i);
+						if(i % 2){
+							EXPECT([&key](){ forest::find_leaf("hashed", key); }).toThrowError();
+						} else {
+							EXPECT(read_leaf(forest::find_leaf("hashed", key)->val())).toBe("v" + std::to_string(i));
+						}
+					}
+				}
+			});
+			
+			IT("should follow updates and removals", {
+				for(int i=0;i<500;i+=4){
+					forest::remove_leaf("hashed", "k"+std::to_string(1000+i));
+				}
+				for(int i=1;i<500;i+=4){
+					forest::insert_leaf("hashed", "k"+std::to_string(1000+i), forest::make_leaf("n" + std::to_string(i)));
+				}
+				for(int i=0;i<500;i++){
+					string key = "k"+std::to_string(1000+i);
+					if(i % 4 == 1){
+						EXPECT(read_leaf(forest::find_leaf("hashed", key)->val())).toBe("n" + std::to_string(i));
+					} else if(i % 4 == 2){
+						EXPECT(read_leaf(forest::find_leaf("hashed", key)->val())).toBe("v" + std::to_string(i));
+					} else {
+						EXPECT([&key](){ forest::find_leaf("hashed", key); }).toThrowError();
+					}
+				}
+			});
+			
+			IT("leaf found by the index should move through the tree", {
+				forest::Leaf leaf = forest::find_leaf("hashed", "k1002");
+				EXPECT(leaf->move_forward()).toBe(true);
+				EXPECT(leaf->key()).toBe("k1005");
+			});
+			
+			IT("should find leafs with a bounded index", {
+				forest::config_hash_index_size(8);
+				for(int round=0;round<2;round++){
+					for(int i=2;i<500;i+=4){
+						EXPECT(read_leaf(forest::find_leaf("hashed", "k"+std::to_string(1000+i))->val())).toBe("v" + std::to_string(i));
+					}
+				}
+				forest::config_hash_index_size(100000);
+			});
+		});
+		
+		DESCRIBE("Add `ints` tree with integer keys", {
+			BEFORE_ALL({
+				forest::plant_tree(forest::TREE_TYPES::KEY_INT64, "ints");
+				for(int i=-100;i<100;i+=3){
+					forest::insert_leaf("ints", forest::int_key((std::int64_t)i * 1000000007), forest::make_leaf("v" + std::to_string(i)));
+				}
+			});
+			
+			AFTER_ALL({
+				forest::cut_tree("ints");
+			});
+			
+			IT("keys should be ordered as integers", {
+				forest::Leaf leaf = forest::find_leaf("ints");
+				int i = -100;
+				do{
+					EXPECT(forest::key_to_int(leaf->key()) == (std::int64_t)i * 1000000007).toBe(true);
+					EXPECT(read_leaf(leaf->val())).toBe("v" + std::to_string(i));
+					i += 3;
+				} while(leaf->move_forward());
+				EXPECT(i).toBe(101);
+			});
+			
+			IT("should convert boundary values", {
+				EXPECT(forest::key_to_int(forest::int_key(INT64_MIN)) == INT64_MIN).toBe(true);
+				EXPECT(forest::key_to_int(forest::int_key(INT64_MAX)) == INT64_MAX).toBe(true);
+				EXPECT(forest::key_to_uint(forest::uint_key(UINT64_MAX)) == UINT64_MAX).toBe(true);
+				EXPECT(forest::int_key(-1) < forest::int_key(0)).toBe(true);
+			});
+			
+			IT("should not accept keys of other format", {
+				EXPECT([](){ forest::insert_leaf("ints", "abc", forest::make_leaf("v")); }).toThrowError();
+				EXPECT([](){ forest::key_to_int("abc"); }).toThrowError();
+			});
+		});
+		
+		DESCRIBE("Add `composite` tree with composite keys", {
+			vector<tuple<string, std::int64_t, std::uint64_t>> tuples = {
+				{"", -5, 1}, {"", 0, 0}, {"a", -1000, 7}, {"a", 9, 1}, {"a", 10, 0},
+				{"a b", 0, 0}, {"a!", 0, 0}, {"ab", INT64_MIN, 0}, {"ab", INT64_MAX, UINT64_MAX},
+				{string("ab\0", 3), 0, 0}, {"ab\x7f", 0, 0}, {"ab\xff", 0, 0}, {"b", 0, 0}
+			};
+			
+			BEFORE_ALL({
+				forest::plant_tree(forest::TREE_TYPES::KEY_STRING, "composite");
+				for(int i=tuples.size()-1;i>=0;i--){
+					auto& t = tuples[i];
+					forest::LeafKey key = forest::KeyBuilder().add_string(get<0>(t)).add_int(get<1>(t)).add_uint(get<2>(t)).key();
+					forest::insert_leaf("composite", key, forest::make_leaf("v" + std::to_string(i)));
+				}
+			});
+			
+			AFTER_ALL({
+				forest::cut_tree("composite");
+			});
+			
+			IT("keys should be ordered as tuples", {
+				forest::Leaf leaf = forest::find_leaf("composite");
+				int i = 0;
+				do{
+					EXPECT(read_leaf(leaf->val())).toBe("v" + std::to_string(i));
+					forest::KeyParser parser(leaf->key());
+					EXPECT(parser.read_string()).toBe(get<0>(tuples[i]));
+					EXPECT(parser.read_int() == get<1>(tuples[i])).toBe(true);
+					EXPECT(parser.read_uint() == get<2>(tuples[i])).toBe(true);
+					EXPECT(parser.eof()).toBe(true);
+					i++;
+				} while(leaf->move_forward());
+				EXPECT(i).toBe((int)tuples.size());
+			});
+			
+			IT("keys should not contain whitespaces", {
+				forest::LeafKey key = forest::KeyBuilder().add_string("a b\n\t").key();
+				EXPECT(key.find_first_of(" \n\t") == std::string::npos).toBe(true);
+			});
+		});
+		
+		DESCRIBE("Add `mmap` tree with 300 leafs and mapped leaf files", {
+			BEFORE_ALL({
+				forest::config_mmap_leafs(true);
+				forest::plant_tree(forest::TREE_TYPES::KEY_STRING, "mmap");
+				for(int i=0;i<300;i++){
+					forest::insert_leaf("mmap", "k"+std::to_string(100+i), forest::make_leaf("value_" + std::to_string(i)));
+				}
+			});
+			
+			AFTER_ALL({
+				forest::cut_tree("mmap");
+				forest::config_mmap_leafs(false);
+			});
+			
+			IT("all leafs should be read from the evicted nodes", {
+				for(int i=0;i<300;i+=7){
+					auto val = forest::find_leaf("mmap", "k"+std::to_string(100+i))->val();
+					EXPECT(read_leaf(val)).toBe("value_" + std::to_string(i));
+					auto reader = val->get_reader();
+					EXPECT(std::string(reader.view())).toBe("value_" + std::to_string(i));
+				}
+			});
+			
+			IT("updated leafs should be read from the new files", {
+				forest::update_leaf("mmap", "k150", forest::make_leaf("new_value"));
+				for(int i=0;i<300;i+=7){
+					forest::find_leaf("mmap", "k"+std::to_string(100+i));
+				}
+				EXPECT(read_leaf(forest::find_leaf("mmap", "k150")->val())).toBe("new_value");
+			});
+		});
+		
+		DESCRIBE("Add `compressed` tree with front coded keys", {
+			BEFORE_ALL({
+				forest::config_compress_keys(true);
+				forest::plant_tree(forest::TREE_TYPES::KEY_STRING, "compressed");
+				for(int i=0;i<500;i++){
+					forest::insert_leaf("compressed", "tenant_0042/users/"+std::to_string(1000+i), forest::make_leaf("v" + std::to_string(i)));
+				}
+			});
+			
+			AFTER_ALL({
+				forest::cut_tree("compressed");
+				forest::config_compress_keys(false);
+			});
+			
+			IT("all leafs should be read from the compressed nodes", {
+				for(int i=0;i<500;i+=3){
+					EXPECT(read_leaf(forest::find_leaf("compressed", "tenant_0042/users/"+std::to_string(1000+i))->val())).toBe("v" + std::to_string(i));
+				}
+			});
+			
+			IT("nodes written in both formats should be read", {
+				forest::config_compress_keys(false);
+				for(int i=0;i<500;i+=5){
+					forest::update_leaf("compressed", "tenant_0042/users/"+std::to_string(1000+i), forest::make_leaf("n" + std::to_string(i)));
+				}
+				forest::config_compress_keys(true);
+				forest::Leaf leaf = forest::find_leaf("compressed");
+				int i = 0;
+				do{
+					EXPECT(leaf->key()).toBe("tenant_0042/users/"+std::to_string(1000+i));
+					EXPECT(read_leaf(leaf->val())).toBe((i % 5 ? "v" : "n") + std::to_string(i));
+					i++;
+				} while(leaf->move_forward());
+				EXPECT(i).toBe(500);
+			});
+		});
+		
+		DESCRIBE("Add `separators` tree with long common key prefixes", {
+			BEFORE_ALL({
+				forest::plant_tree(forest::TREE_TYPES::KEY_STRING, "separators");
+				for(int i=0;i<600;i++){
+					int k = (i * 7) % 600;
+					forest::insert_leaf("separators", "org/department/team/member_"+std::to_string(1000+k), forest::make_leaf("v" + std::to_string(k)));
+				}
+			});
+			
+			AFTER_ALL({
+				forest::cut_tree("separators");
+			});
+			
+			IT("leafs should be found between truncated separators", {
+				for(int i=0;i<600;i++){
+					EXPECT(read_leaf(forest::find_leaf("separators", "org/department/team/member_"+std::to_string(1000+i))->val())).toBe("v" + std::to_string(i));
+				}
+				EXPECT([](){ forest::find_leaf("separators", "org/department/team/member_"); }).toThrowError();
+				EXPECT((int)forest::count_range("separators", "org/department/team/member_1100", "org/department/team/member_1200")).toBe(100);
+			});
+			
+			IT("iteration should pass every leaf after removals", {
+				for(int i=0;i<600;i+=2){
+					forest::remove_leaf("separators", "org/department/team/member_"+std::to_string(1000+i));
+				}
+				forest::Leaf leaf = forest::find_leaf("separators");
+				int i = 1;
+				do{
+					EXPECT(leaf->key()).toBe("org/department/team/member_"+std::to_string(1000+i));
+					i += 2;
+				} while(leaf->move_forward());
+				EXPECT(i).toBe(601);
+			});
+		});
+		
+		DESCRIBE("Cursor over `cursor` tree with 500 leafs", {
+			BEFORE_ALL({
+				forest::plant_tree(forest::TREE_TYPES::KEY_STRING, "cursor");
+				for(int i=0;i<500;i++){
+					forest::insert_leaf("cursor", "k"+std::to_string(100+i), forest::make_leaf("v" + std::to_string(i)));
+				}
+			});
+			
+			AFTER_ALL({
+				forest::cut_tree("cursor");
+			});
+			
+			IT("should read all leafs node by node", {
+				forest::Cursor cursor = forest::open_cursor("cursor");
+				int i = 0;
+				int calls = 0;
+				while(cursor->next()){
+					calls++;
+					for(forest::details::uint_t j = 0; j < cursor->size(); j++){
+						EXPECT(cursor->key(j)).toBe("k"+std::to_string(100+i));
+						EXPECT(read_leaf(cursor->val(j))).toBe("v" + std::to_string(i));
+						i++;
+					}
+				}
+				EXPECT(i).toBe(500);
+				EXPECT(calls < 500).toBe(true);
+				EXPECT(cursor->next()).toBe(false);
+			});
+			
+			IT("should read a range of leafs", {
+				forest::Cursor cursor = forest::open_cursor("cursor", "k150", "k450");
+				int i = 50;
+				while(cursor->next()){
+					for(forest::details::uint_t j = 0; j < cursor->size(); j++){
+						EXPECT(cursor->key(j)).toBe("k"+std::to_string(100+i));
+						i++;
+					}
+				}
+				EXPECT(i).toBe(350);
+				EXPECT([&cursor](){ cursor->key(0); }).toThrowError();
+			});
+		});
+		
+		DESCRIBE("Snapshot of `snap` tree with 100 leafs", {
+			forest::Snapshot snap;
+			
+			BEFORE_ALL({
+				forest::plant_tree(forest::TREE_TYPES::KEY_STRING, "snap");
+				for(int i=0;i<100;i++){
+					forest::insert_leaf("snap", "k"+std::to_string(100+i), forest::make_leaf("old_" + std::to_string(i)));
+				}
+				snap = forest::snapshot("snap");
+				for(int i=0;i<100;i+=2){
+					forest::remove_leaf("snap", "k"+std::to_string(100+i));
+					forest::update_leaf("snap", "k"+std::to_string(101+i), forest::make_leaf("new_" + std::to_string(i)));
+					forest::insert_leaf("snap", "n"+std::to_string(100+i), forest::make_leaf("new_" + std::to_string(i)));
+				}
+			});
+			
+			AFTER_ALL({
+				snap = nullptr;
+				forest::cut_tree("snap");
+			});
+			
+			IT("should iterate through the image taken before changes", {
+				forest::Leaf leaf = forest::find_leaf(snap);
+				int i = 0;
+				do{
+					EXPECT(leaf->key()).toBe("k"+std::to_string(100+i));
+					EXPECT(read_leaf(leaf->val())).toBe("old_" + std::to_string(i));
+					i++;
+				} while(leaf->move_forward());
+				EXPECT(i).toBe(100);
+			});
+			
+			IT("should find leafs of the image", {
+				EXPECT(read_leaf(forest::find_leaf(snap, "k110")->val())).toBe("old_10");
+				EXPECT([&snap](){ forest::find_leaf(snap, "n110"); }).toThrowError();
+				forest::Leaf leaf = forest::find_leaf(snap, forest::LEAF_POSITION::END);
+				EXPECT(leaf->key()).toBe("k199");
+				EXPECT(leaf->move_back()).toBe(true);
+				EXPECT(leaf->key()).toBe("k198");
+				EXPECT(forest::find_leaf(snap, "k150", forest::LEAF_POSITION::UPPER)->key()).toBe("k151");
+			});
+			
+			IT("should iterate back and change the direction", {
+				forest::Leaf leaf = forest::find_leaf(snap, forest::LEAF_POSITION::END);
+				int i = 99;
+				do{
+					EXPECT(leaf->key()).toBe("k"+std::to_string(100+i));
+					EXPECT(read_leaf(leaf->val())).toBe("old_" + std::to_string(i));
+					i--;
+				} while(i >= 50 && leaf->move_back());
+				EXPECT(leaf->move_forward()).toBe(true);
+				EXPECT(leaf->key()).toBe("k151");
+				EXPECT(read_leaf(leaf->val())).toBe("old_51");
+				EXPECT(leaf->move_back()).toBe(true);
+				EXPECT(leaf->key()).toBe("k150");
+			});
+			
+			IT("tree itself should have the changes", {
+				EXPECT([](){ forest::find_leaf("snap", "k110"); }).toThrowError();
+				EXPECT(read_leaf(forest::find_leaf("snap", "n110")->val())).toBe("new_10");
+			});
+		});
+		
 		DESCRIBE("Add 20 trees with annotations", {
 			BEFORE_ALL({
 				for(int i=0;i<20;i++){
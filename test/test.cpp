@@ -16,6 +16,7 @@ using namespace std;
 SCENARIO_START
 #include "src/single_thread.forest.test.cpp"
 #include "src/multi_thread.forest.test.cpp"
+#include "src/engine.forest.test.cpp"
 //#include "src/performance.forest.test.cpp"
 SCENARIO_END
 